@@ -5,6 +5,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <fontconfig/fontconfig.h>
 #include <getopt.h>
 #include <grp.h>
@@ -15,6 +16,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-client.h>
 #include <wayland-server-core.h>
@@ -24,6 +26,7 @@
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_cursor.h>
+#include <wlr/types/wlr_cursor_shape_v1.h>
 #include <wlr/types/wlr_data_control_v1.h>
 #include <wlr/types/wlr_data_device.h>
 #include <wlr/types/wlr_export_dmabuf_v1.h>
@@ -32,6 +35,7 @@
 #include <wlr/types/wlr_idle_notify_v1.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_pointer_constraints_v1.h>
+#include <wlr/types/wlr_presentation_time.h>
 #include <wlr/types/wlr_primary_selection_v1.h>
 #include <wlr/types/wlr_relative_pointer_v1.h>
 #include <wlr/types/wlr_scene.h>
@@ -48,16 +52,23 @@
 #include <wlr/xwayland.h>
 #endif
 
+#include "chord.h"
+#include "config_cache.h"
 #include "idle_inhibit_v1.h"
 #include "input_manager.h"
+#include "input_record.h"
 #include "ipc_server.h"
 #include "keybinding.h"
+#include "launcher.h"
 #include "layer_shell.h"
 #include "message.h"
 #include "output.h"
 #include "parse.h"
 #include "seat.h"
 #include "server.h"
+#include "spawn.h"
+#include "startup_trace.h"
+#include "util.h"
 #include "workspace.h"
 #include "xdg_shell.h"
 #if CG_HAS_XWAYLAND
@@ -143,17 +154,31 @@ usage(FILE *file, const char *const cage) {
 	        " -s\t\t Show information about the current setup and exit\n"
 	        " -v\t\t Show the version number and exit\n"
 	        " --bs\t\t \"bad security\": Enable features with potential "
-	        "security implications (see man page)\n",
+	        "security implications (see man page)\n"
+	        " --config-cache <path>\t Load the parsed configuration from "
+	        "<path> if it is up to date or write it there\n"
+	        " --defer-init\t Load the cursor theme and fonts after the first "
+	        "frame\n"
+	        " --launcher\t Run the commands of exec from a helper process "
+	        "started at boot\n"
+	        " --startup-trace <path>\t Write the duration of the startup "
+	        "phases to <path>\n",
 	        cage);
 }
 
 static bool
 parse_args(struct cg_server *server, int argc, char *argv[],
-           char **config_path) {
+           char **config_path, char **trace_path, char **cache_path,
+           bool *launcher) {
 	int c, option_index;
 	server->enable_socket = false;
-	static struct option long_options[] = {{"bs", no_argument, 0, 0},
-	                                       {0, 0, 0, 0}};
+	static struct option long_options[] = {
+	    {"bs", no_argument, 0, 0},
+	    {"config-cache", required_argument, 0, 'C'},
+	    {"defer-init", no_argument, 0, 'd'},
+	    {"launcher", no_argument, 0, 'l'},
+	    {"startup-trace", required_argument, 0, 't'},
+	    {0, 0, 0, 0}};
 #ifndef __clang_analyzer__
 	while((c = getopt_long(argc, argv, "c:hvse", long_options,
 	                       &option_index)) != -1) {
@@ -179,6 +204,20 @@ parse_args(struct cg_server *server, int argc, char *argv[],
 		case 'e':
 			server->enable_socket = true;
 			break;
+		case 'd':
+			server->defer_init = true;
+			break;
+		case 'l':
+			*launcher = true;
+			break;
+		case 't':
+			free(*trace_path);
+			*trace_path = strdup(optarg);
+			break;
+		case 'C':
+			free(*cache_path);
+			*cache_path = strdup(optarg);
+			break;
 		default:
 			usage(stderr, argv[0]);
 			return false;
@@ -194,54 +233,98 @@ parse_args(struct cg_server *server, int argc, char *argv[],
 	return true;
 }
 
-/* Parse config file. Lines longer than "max_line_size" are ignored */
+/* Parse config file. Returns 1 if it cannot be opened or read, 2 if memory
+ * allocation fails and -1 if a line cannot be parsed. If cache_path is not
+ * NULL, the configuration is loaded from the snapshot at cache_path if it is
+ * up to date, which sets cached, and otherwise written there. */
 int
-set_configuration(struct cg_server *server,
-                  const char *const config_file_path) {
-	FILE *config_file = fopen(config_file_path, "r");
-	if(config_file == NULL) {
-		wlr_log(WLR_ERROR, "Could not open config file \"%s\"",
-		        config_file_path);
-		return 1;
-	}
-	uint32_t line_length = 64;
-	char *line = calloc(line_length, sizeof(char));
-	for(unsigned int line_num = 1;; ++line_num) {
-#ifndef __clang_analyzer__
-		while((fgets(line + strlen(line), line_length - strlen(line),
-		             config_file) != NULL) &&
-		      (strcspn(line, "\n") == line_length - 1)) {
-			line_length *= 2;
-			line = reallocarray(line, line_length, sizeof(char));
-			if(line == NULL) {
-				wlr_log(WLR_ERROR, "Could not allocate buffer for reading "
-				                   "configuration file.");
-				fclose(config_file);
-				return 2;
-			}
+set_configuration(struct cg_server *server, const char *const config_file_path,
+                  const char *cache_path, bool *cached) {
+	*cached = false;
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	size_t len;
+	char *config = read_file(config_file_path, &len);
+	if(config == NULL) {
+		int err = errno;
+		wlr_log_errno(WLR_ERROR, "Could not read config file \"%s\"",
+		              config_file_path);
+		return err == ENOMEM ? 2 : 1;
+	}
+	/* An unmodified copy is kept for "reload", which compares it against
+	 * the contents of the file at that time */
+	char *text = malloc(len + 1);
+	char *path = strdup(config_file_path);
+	if(text == NULL || path == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for configuration");
+		free(text);
+		free(path);
+		free(config);
+		return 2;
+	}
+	memcpy(text, config, len + 1);
+	struct cg_config_cache *cache = NULL;
+	if(cache_path != NULL) {
+		int cache_ret = config_cache_load(server, cache_path, text, len);
+		if(cache_ret < 0) {
+			free(text);
+			free(path);
+			free(config);
+			return -1;
 		}
-#endif
-		if(strlen(line) == 0) {
-			break;
+		*cached = cache_ret == 0;
+		if(!*cached) {
+			cache = config_cache_create(text, len);
+		}
+	}
+	/* The file is read at once and each line is parsed in place */
+	char *end = config + len;
+	char *line = *cached ? end : config;
+	unsigned int line_num = 1;
+	for(; line < end; ++line_num) {
+		char *nl = memchr(line, '\n', end - line);
+		if(nl == NULL) {
+			nl = end;
 		}
-		line[strcspn(line, "\n")] = '\0';
+		*nl = '\0';
 		if(*line != '\0' && *line != '#') {
-			char *errstr;
-			if(parse_rc_line(server, line, &errstr) != 0) {
+			char *errstr = NULL;
+			int err;
+			if(cache == NULL) {
+				err = parse_rc_line(server, line, &errstr);
+			} else {
+				err = config_cache_parse_line(server, cache, line_num, line,
+				                              text + (line - config),
+				                              nl - line, &errstr);
+			}
+			if(err != 0) {
 				wlr_log(WLR_ERROR, "Error in config file \"%s\", line %d\n",
 				        config_file_path, line_num);
-				fclose(config_file);
 				if(errstr != NULL) {
 					free(errstr);
 				}
-				free(line);
+				config_cache_destroy(cache);
+				free(text);
+				free(path);
+				free(config);
 				return -1;
 			}
 		}
-		memset(line, 0, line_length * sizeof(char));
-	}
-	free(line);
-	fclose(config_file);
+		line = nl + 1;
+	}
+	free(config);
+	if(cache != NULL) {
+		config_cache_save(cache, cache_path);
+		config_cache_destroy(cache);
+	}
+	free(server->config_text);
+	free(server->config_path);
+	server->config_text = text;
+	server->config_path = path;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	wlr_log(WLR_INFO, "Loaded \"%s\"%s in %.3f ms", config_file_path,
+	        *cached ? " from cache" : "",
+	        (timespec_to_ns(&now) - timespec_to_ns(&start)) / 1e6);
 	return 0;
 }
 
@@ -287,21 +370,38 @@ main(int argc, char *argv[]) {
 	struct wlr_screencopy_manager_v1 *screencopy_manager = NULL;
 	struct wlr_data_control_manager_v1 *data_control_manager = NULL;
 	struct wlr_viewporter *viewporter = NULL;
+	struct wlr_presentation *presentation = NULL;
 	struct wlr_xdg_output_manager_v1 *output_manager = NULL;
 	struct wlr_xdg_shell *xdg_shell = NULL;
 	wl_list_init(&server.input_config);
 	wl_list_init(&server.output_config);
 	wl_list_init(&server.output_priorities);
 	wl_list_init(&server.xdg_decorations);
+	wl_list_init(&server.children);
+	wl_list_init(&server.stopped_replays);
+	wl_list_init(&server.launch_stats);
 
 	int ret = 0;
 	server.bs = 0;
 	server.message_config.enabled = true;
+	server.message_config.focus_indicator = true;
 
 	char *config_path = NULL;
-	if(!parse_args(&server, argc, argv, &config_path)) {
+	char *trace_path = NULL;
+	char *cache_path = NULL;
+	bool launcher = false;
+	if(!parse_args(&server, argc, argv, &config_path, &trace_path,
+	               &cache_path, &launcher)) {
+		free(trace_path);
 		goto end;
 	}
+	if(trace_path != NULL) {
+		startup_trace_start(&server, trace_path);
+		free(trace_path);
+		if(server.defer_init) {
+			startup_trace_expect(&server, CG_STARTUP_DEFERRED_INIT);
+		}
+	}
 
 #ifdef DEBUG
 	wlr_log_init(WLR_DEBUG, NULL);
@@ -309,6 +409,14 @@ main(int argc, char *argv[]) {
 	wlr_log_init(WLR_ERROR, NULL);
 #endif
 
+	/* Fork the launcher before the display and the backend exist, such
+	 * that it neither shares their memory nor holds the session, DRM or
+	 * input devices. It drops root privileges itself. */
+	if(launcher && launcher_start(&server, drop_permissions) != 0) {
+		wlr_log(WLR_ERROR, "Failed to start launcher, running commands "
+		                   "directly");
+	}
+
 	server.modes = malloc(4 * sizeof(char *));
 	server.modecursors = malloc(4 * sizeof(char *));
 	if(!server.modes || !server.modecursors) {
@@ -368,6 +476,7 @@ main(int argc, char *argv[]) {
 	}
 
 	server.nws = 1;
+	server.idle_interval = 100;
 	server.views_curr_id = 1;
 	server.tiles_curr_id = 1;
 	server.message_config.fg_color[0] = 0.0;
@@ -394,6 +503,7 @@ main(int argc, char *argv[]) {
 	sigpipe_source =
 	    wl_event_loop_add_signal(event_loop, SIGPIPE, handle_signal, &server);
 	server.event_loop = event_loop;
+	startup_trace_phase(&server, "display");
 
 	backend = wlr_backend_autocreate(event_loop, &server.session);
 	server.headless_backend = wlr_headless_backend_create(event_loop);
@@ -403,6 +513,7 @@ main(int argc, char *argv[]) {
 		goto end;
 	}
 	server.backend = backend;
+	startup_trace_phase(&server, "backend");
 
 	if(!drop_permissions()) {
 		ret = 1;
@@ -416,12 +527,20 @@ main(int argc, char *argv[]) {
 		goto end;
 	}
 
+	server.chords = chord_create();
+	if(server.chords == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate chords");
+		ret = 1;
+		goto end;
+	}
+
 	server.renderer = wlr_renderer_autocreate(backend);
 	if(!server.renderer) {
 		wlr_log(WLR_ERROR, "Unable to create the wlroots renderer");
 		ret = 1;
 		goto end;
 	}
+	startup_trace_phase(&server, "renderer");
 
 	server.allocator =
 	    wlr_allocator_autocreate(server.backend, server.renderer);
@@ -430,6 +549,7 @@ main(int argc, char *argv[]) {
 		ret = 1;
 		goto end;
 	}
+	startup_trace_phase(&server, "allocator");
 
 	wlr_renderer_init_wl_display(server.renderer, server.wl_display);
 
@@ -449,6 +569,7 @@ main(int argc, char *argv[]) {
 		ret = 1;
 		goto end;
 	}
+	startup_trace_phase(&server, "ipc");
 
 	server.scene = wlr_scene_create();
 	if(!server.scene) {
@@ -495,6 +616,7 @@ main(int argc, char *argv[]) {
 	 * first output and ignore subsequent outputs. */
 	server.new_output.notify = handle_new_output;
 	wl_signal_add(&backend->events.new_output, &server.new_output);
+	startup_trace_phase(&server, "compositor");
 
 	server.seat = seat_create(&server);
 	if(!server.seat) {
@@ -502,6 +624,7 @@ main(int argc, char *argv[]) {
 		ret = 1;
 		goto end;
 	}
+	startup_trace_phase(&server, "seat");
 
 	server.idle_inhibit_v1 = wlr_idle_inhibit_v1_create(server.wl_display);
 	server.idle = wlr_idle_notifier_v1_create(server.wl_display);
@@ -553,6 +676,15 @@ main(int argc, char *argv[]) {
 		goto end;
 	}
 
+	/* The scene graph sends the presentation feedback to the clients on its
+	 * own once the global exists */
+	presentation = wlr_presentation_create(server.wl_display, backend, 2);
+	if(!presentation) {
+		wlr_log(WLR_ERROR, "Unable to create the presentation interface");
+		ret = 1;
+		goto end;
+	}
+
 	export_dmabuf_manager =
 	    wlr_export_dmabuf_manager_v1_create(server.wl_display);
 	if(!export_dmabuf_manager) {
@@ -617,6 +749,18 @@ main(int argc, char *argv[]) {
 	wl_signal_add(&server.pointer_constraints->events.new_constraint,
 	              &server.new_pointer_constraint);
 
+	server.cursor_shape_manager =
+	    wlr_cursor_shape_manager_v1_create(server.wl_display, 1);
+	if(!server.cursor_shape_manager) {
+		wlr_log(WLR_ERROR, "Unable to create the cursor shape manager");
+		ret = 1;
+		goto end;
+	}
+	server.request_set_cursor_shape.notify = handle_request_set_cursor_shape;
+	wl_signal_add(&server.cursor_shape_manager->events.request_set_shape,
+	              &server.request_set_cursor_shape);
+	startup_trace_phase(&server, "protocols");
+
 #if CG_HAS_XWAYLAND
 	server.xwayland = wlr_xwayland_create(server.wl_display, compositor, true);
 	if(!server.xwayland) {
@@ -636,15 +780,10 @@ main(int argc, char *argv[]) {
 		        server.xwayland->display_name);
 	}
 
-	struct wlr_xcursor *xcursor = wlr_xcursor_manager_get_xcursor(
-	    server.seat->xcursor_manager, DEFAULT_XCURSOR, 1);
-
-	if(xcursor) {
-		struct wlr_xcursor_image *image = xcursor->images[0];
-		wlr_xwayland_set_cursor(server.xwayland,
-		                        wlr_xcursor_image_get_buffer(image),
-		                        image->hotspot_x, image->hotspot_y);
+	if(!server.defer_init) {
+		xwayland_set_default_cursor(&server);
 	}
+	startup_trace_phase(&server, "xwayland");
 #endif
 
 	const char *socket = wl_display_add_socket_auto(server.wl_display);
@@ -653,12 +792,14 @@ main(int argc, char *argv[]) {
 		ret = 1;
 		goto end;
 	}
+	startup_trace_phase(&server, "socket");
 
 	if(!wlr_backend_start(backend)) {
 		wlr_log(WLR_ERROR, "Unable to start the wlroots backend");
 		ret = 1;
 		goto end;
 	}
+	startup_trace_phase(&server, "backend_start");
 
 	if(setenv("WAYLAND_DISPLAY", socket, true) < 0) {
 		wlr_log_errno(WLR_ERROR, "Unable to set WAYLAND_DISPLAY. Clients may "
@@ -684,6 +825,7 @@ main(int argc, char *argv[]) {
 		exit(0);
 	}
 
+	bool cached = false;
 	{ // config_file should only be visible as long as it is valid
 		int conf_ret = 1;
 		char *config_file = get_config_file(config_path);
@@ -692,7 +834,8 @@ main(int argc, char *argv[]) {
 			ret = 1;
 			goto end;
 		} else {
-			conf_ret = set_configuration(&server, config_file);
+			conf_ret =
+			    set_configuration(&server, config_file, cache_path, &cached);
 			free(config_file);
 		}
 
@@ -701,7 +844,8 @@ main(int argc, char *argv[]) {
 			char *default_conf = "/etc/xdg/cagebreak/config";
 			wlr_log(WLR_INFO, "Loading default configuration file: \"%s\"",
 			        default_conf);
-			conf_ret = set_configuration(&server, default_conf);
+			conf_ret = set_configuration(&server, default_conf, cache_path,
+			                             &cached);
 		}
 
 		if(conf_ret != 0) {
@@ -712,6 +856,9 @@ main(int argc, char *argv[]) {
 			goto end;
 		}
 	}
+	/* Compare with the "config" phase of a start without a cache to see
+	 * what the cache saves */
+	startup_trace_phase(&server, cached ? "config_cache" : "config");
 
 	{
 		struct wl_list tmp_list;
@@ -727,6 +874,7 @@ main(int argc, char *argv[]) {
 		server.curr_output =
 		    wl_container_of(server.outputs.next, server.curr_output, link);
 	}
+	startup_trace_phase(&server, "outputs");
 
 	/* Place the cursor to the top left of the output layout. */
 	wlr_cursor_warp(server.seat->cursor, NULL, 0, 0);
@@ -769,6 +917,7 @@ end:
 	if(config_path) {
 		free(config_path);
 	}
+	free(cache_path);
 
 	struct cg_output_config *output_config, *output_config_tmp;
 	wl_list_for_each_safe(output_config, output_config_tmp,
@@ -791,10 +940,14 @@ end:
 	if(server.keybindings != NULL) {
 		keybinding_list_free(server.keybindings);
 	}
+	chord_free(server.chords);
 
 	if(server.message_config.font != NULL) {
 		free(server.message_config.font);
 	}
+	input_record_stop(&server);
+	input_replay_finish(&server);
+	startup_trace_finish(&server);
 	server.running = false;
 	if(server.seat != NULL) {
 		seat_destroy(server.seat);
@@ -807,6 +960,23 @@ end:
 		wl_event_source_remove(sigpipe_source);
 	}
 
+	if(server.overlay_clock != NULL) {
+		wl_event_source_remove(server.overlay_clock);
+	}
+	if(server.stats_stream != NULL) {
+		wl_event_source_remove(server.stats_stream);
+	}
+	if(server.reload_idle != NULL) {
+		wl_event_source_remove(server.reload_idle);
+	}
+	if(server.deferred_init != NULL) {
+		wl_event_source_remove(server.deferred_init);
+	}
+	launcher_finish(&server);
+	spawn_finish(&server);
+	free(server.config_text);
+	free(server.config_path);
+
 	if(server.input) {
 		wl_list_remove(&server.input->new_input.link);
 		wl_list_remove(&server.input->virtual_keyboard_new.link);
@@ -833,6 +1003,10 @@ end:
 		wl_list_remove(&server.new_pointer_constraint.link);
 	}
 
+	if(server.cursor_shape_manager) {
+		wl_list_remove(&server.request_set_cursor_shape.link);
+	}
+
 	if(server.new_output.notify) {
 		wl_list_remove(&server.new_output.link);
 	}
@@ -0,0 +1,240 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <wlr/util/log.h>
+
+#include "chord.h"
+#include "keybinding.h"
+
+// Source state of the transitions taken by the first key of a chord
+#define CHORD_ROOT_FLAG (1u << 31)
+
+struct cg_chords *
+chord_create(void) {
+	struct cg_chords *chords = calloc(1, sizeof(struct cg_chords));
+	if(chords == NULL) {
+		return NULL;
+	}
+	chords->timeout = CG_CHORD_DEFAULT_TIMEOUT;
+	return chords;
+}
+
+void
+chord_free(struct cg_chords *chords) {
+	if(chords == NULL) {
+		return;
+	}
+	for(uint32_t i = 1; i < chords->nstates; ++i) {
+		if(chords->states[i].binding != NULL) {
+			keybinding_free(chords->states[i].binding, true);
+		}
+	}
+	free(chords->states);
+	free(chords->edges);
+	free(chords);
+}
+
+uint32_t
+chord_root(uint16_t mode) {
+	return CHORD_ROOT_FLAG | mode;
+}
+
+static uint32_t
+edge_hash(uint32_t from, xkb_mod_mask_t modifiers, xkb_keysym_t key) {
+	uint32_t hash = from * 0x9e3779b1u;
+	hash ^= modifiers * 0x85ebca6bu;
+	hash ^= key * 0xc2b2ae35u;
+	return hash ^ (hash >> 16);
+}
+
+static struct cg_chord_edge *
+edge_find(const struct cg_chords *chords, uint32_t from,
+          xkb_mod_mask_t modifiers, xkb_keysym_t key) {
+	if(chords->edges_cap == 0) {
+		return NULL;
+	}
+	uint32_t mask = chords->edges_cap - 1;
+	for(uint32_t i = edge_hash(from, modifiers, key) & mask;;
+	    i = (i + 1) & mask) {
+		struct cg_chord_edge *edge = &chords->edges[i];
+		if(edge->from == 0 || (edge->from == from &&
+		                       edge->modifiers == modifiers &&
+		                       edge->key == key)) {
+			return edge;
+		}
+	}
+}
+
+static int
+edges_grow(struct cg_chords *chords) {
+	uint32_t old_cap = chords->edges_cap;
+	struct cg_chord_edge *old = chords->edges;
+	uint32_t cap = old_cap == 0 ? 16 : old_cap * 2;
+	struct cg_chord_edge *edges = calloc(cap, sizeof(struct cg_chord_edge));
+	if(edges == NULL) {
+		return -1;
+	}
+	chords->edges = edges;
+	chords->edges_cap = cap;
+	for(uint32_t i = 0; i < old_cap; ++i) {
+		if(old[i].from != 0) {
+			*edge_find(chords, old[i].from, old[i].modifiers, old[i].key) =
+			    old[i];
+		}
+	}
+	free(old);
+	return 0;
+}
+
+static uint32_t
+state_new(struct cg_chords *chords) {
+	if(chords->nstates == 0) {
+		// State 0 is reserved
+		chords->nstates = 1;
+	}
+	if(chords->nstates == chords->states_cap) {
+		uint32_t cap = chords->states_cap == 0 ? 16 : chords->states_cap * 2;
+		struct cg_chord_state *states =
+		    realloc(chords->states, cap * sizeof(struct cg_chord_state));
+		if(states == NULL) {
+			return 0;
+		}
+		chords->states = states;
+		chords->states_cap = cap;
+	}
+	chords->states[chords->nstates] =
+	    (struct cg_chord_state){.binding = NULL, .nchildren = 0};
+	return chords->nstates++;
+}
+
+/* Empties the slot of edge, moving later edges of the same probe sequence
+ * into the hole such that they can still be found */
+static void
+edge_remove(struct cg_chords *chords, struct cg_chord_edge *edge) {
+	uint32_t mask = chords->edges_cap - 1;
+	uint32_t hole = edge - chords->edges;
+	for(uint32_t i = (hole + 1) & mask; chords->edges[i].from != 0;
+	    i = (i + 1) & mask) {
+		struct cg_chord_edge *next = &chords->edges[i];
+		uint32_t home =
+		    edge_hash(next->from, next->modifiers, next->key) & mask;
+		/* The edge may only move if the hole is between its home slot
+		 * and its current slot */
+		if(((i - home) & mask) >= ((i - hole) & mask)) {
+			chords->edges[hole] = *next;
+			hole = i;
+		}
+	}
+	chords->edges[hole].from = 0;
+	--chords->nedges;
+}
+
+/* Returns the state reached from "from" by key, creating it if needed */
+static uint32_t
+edge_add(struct cg_chords *chords, uint32_t from,
+         const struct cg_chord_key *key) {
+	struct cg_chord_edge *edge =
+	    edge_find(chords, from, key->modifiers, key->key);
+	if(edge != NULL && edge->from != 0) {
+		return edge->to;
+	}
+	if(2 * (chords->nedges + 1) > chords->edges_cap &&
+	   edges_grow(chords) != 0) {
+		return 0;
+	}
+	uint32_t to = state_new(chords);
+	if(to == 0) {
+		return 0;
+	}
+	edge = edge_find(chords, from, key->modifiers, key->key);
+	*edge = (struct cg_chord_edge){
+	    .from = from, .modifiers = key->modifiers, .key = key->key, .to = to};
+	++chords->nedges;
+	if(!(from & CHORD_ROOT_FLAG)) {
+		++chords->states[from].nchildren;
+	}
+	return to;
+}
+
+/* Adds the chord described by cfg. On success, the automaton takes
+ * ownership of cfg->kb, replacing an earlier binding of the same chord. */
+int
+chord_add(struct cg_chords *chords, const struct cg_chord_config *cfg) {
+	/* Check for conflicts with existing chords before changing anything */
+	uint32_t state = chord_root(cfg->mode);
+	for(uint32_t i = 0; i < cfg->nkeys; ++i) {
+		state = chord_step(chords, state, cfg->keys[i].modifiers,
+		                   cfg->keys[i].key);
+		if(state == 0) {
+			break;
+		}
+		if(i + 1 < cfg->nkeys && chords->states[state].binding != NULL) {
+			wlr_log(WLR_ERROR,
+			        "Chord conflicts with a shorter chord bound to \"%s\"",
+			        keybinding_action_string[chords->states[state]
+			                                     .binding->action]);
+			return -1;
+		}
+		if(i + 1 == cfg->nkeys && chords->states[state].nchildren != 0) {
+			wlr_log(WLR_ERROR, "Chord is a prefix of a longer chord");
+			return -1;
+		}
+	}
+
+	/* States are only appended, so the ones created for this chord are
+	 * those from first_new on */
+	uint32_t old_nstates = chords->nstates;
+	uint32_t first_new = old_nstates == 0 ? 1 : old_nstates;
+	uint32_t path[CG_CHORD_MAX_KEYS + 1];
+	path[0] = chord_root(cfg->mode);
+	for(uint32_t i = 0; i < cfg->nkeys; ++i) {
+		path[i + 1] = edge_add(chords, path[i], &cfg->keys[i]);
+		if(path[i + 1] != 0) {
+			continue;
+		}
+		wlr_log(WLR_ERROR, "Failed to allocate memory for chord");
+		/* Don't leave a prefix behind which leads to no binding */
+		for(uint32_t j = i; j-- > 0;) {
+			if(path[j + 1] < first_new) {
+				break;
+			}
+			edge_remove(chords,
+			            edge_find(chords, path[j], cfg->keys[j].modifiers,
+			                      cfg->keys[j].key));
+			if(!(path[j] & CHORD_ROOT_FLAG)) {
+				--chords->states[path[j]].nchildren;
+			}
+		}
+		chords->nstates = old_nstates;
+		return -1;
+	}
+	state = path[cfg->nkeys];
+	struct cg_chord_state *final = &chords->states[state];
+	if(final->binding != NULL && final->binding != cfg->kb) {
+		keybinding_free(final->binding, true);
+	}
+	final->binding = cfg->kb;
+	return 0;
+}
+
+/* Advances the automaton from state by key, returns 0 if there is no
+ * matching transition */
+uint32_t
+chord_step(const struct cg_chords *chords, uint32_t state,
+           xkb_mod_mask_t modifiers, xkb_keysym_t key) {
+	const struct cg_chord_edge *edge =
+	    edge_find(chords, state, modifiers, key);
+	if(edge == NULL || edge->from == 0) {
+		return 0;
+	}
+	return edge->to;
+}
+
+/* Returns the binding to run once state is reached, NULL if more keys are
+ * expected */
+struct keybinding *
+chord_binding(const struct cg_chords *chords, uint32_t state) {
+	return chords->states[state].binding;
+}
@@ -0,0 +1,70 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_CHORD_H
+#define CG_CHORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <xkbcommon/xkbcommon.h>
+
+struct keybinding;
+
+#define CG_CHORD_MAX_KEYS 8
+#define CG_CHORD_DEFAULT_TIMEOUT 1000
+
+struct cg_chord_key {
+	xkb_mod_mask_t modifiers;
+	xkb_keysym_t key;
+};
+
+/* Chord as given by "bind" or "definekey" with comma-separated keys */
+struct cg_chord_config {
+	uint16_t mode;
+	uint32_t nkeys;
+	struct cg_chord_key keys[CG_CHORD_MAX_KEYS];
+	struct keybinding *kb;
+};
+
+struct cg_chord_state {
+	struct keybinding *binding; // Run when the state is reached, or NULL
+	uint32_t nchildren;         // Number of transitions leaving the state
+};
+
+/* Transition of the chord automaton, stored in an open addressing hash
+ * table keyed by the source state and the pressed key */
+struct cg_chord_edge {
+	uint32_t from; // 0 if the slot is empty
+	xkb_mod_mask_t modifiers;
+	xkb_keysym_t key;
+	uint32_t to;
+};
+
+/* All chords compiled into a single automaton. The states reached by the
+ * first key of a chord hang off a virtual root state per mode, see
+ * chord_root. State 0 is unused and means "no chord in progress". */
+struct cg_chords {
+	struct cg_chord_state *states;
+	uint32_t nstates;
+	uint32_t states_cap;
+	struct cg_chord_edge *edges;
+	uint32_t nedges;
+	uint32_t edges_cap; // Power of two
+	uint32_t timeout;   // Milliseconds until a started chord is aborted
+};
+
+struct cg_chords *
+chord_create(void);
+void
+chord_free(struct cg_chords *chords);
+uint32_t
+chord_root(uint16_t mode);
+int
+chord_add(struct cg_chords *chords, const struct cg_chord_config *cfg);
+uint32_t
+chord_step(const struct cg_chords *chords, uint32_t state,
+           xkb_mod_mask_t modifiers, xkb_keysym_t key);
+struct keybinding *
+chord_binding(const struct cg_chords *chords, uint32_t state);
+
+#endif
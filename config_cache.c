@@ -0,0 +1,606 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+
+#include "chord.h"
+#include "config_cache.h"
+#include "input_manager.h"
+#include "keybinding.h"
+#include "message.h"
+#include "output.h"
+#include "parse.h"
+#include "reload.h"
+#include "server.h"
+#include "util.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325
+#define FNV_PRIME 0x100000001b3
+
+enum cg_config_cache_record {
+	CG_CONFIG_CACHE_COMMAND, // Text of the line, parsed again on load
+	CG_CONFIG_CACHE_BINDING, // Parsed keybinding, run directly on load
+};
+
+struct cg_config_cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t nrecords;
+	uint64_t layout; // See layout_hash
+	uint64_t source;
+	uint64_t source_len;
+	uint64_t payload; // Hash of the records following the header
+	uint64_t payload_len;
+};
+
+struct cg_config_cache_reader {
+	char *pos;
+	char *end;
+	bool failed;
+};
+
+/* Record which was decoded but not run yet */
+struct cg_config_cache_entry {
+	uint32_t line;
+	char *text; // Points into the snapshot, NULL for keybindings
+	struct keybinding *kb;
+};
+
+static const char *const action_names[] = {
+    FOREACH_KEYBINDING(GENERATE_STRING)};
+
+static uint64_t
+hash_bytes(uint64_t hash, const void *data, size_t len) {
+	const unsigned char *bytes = data;
+	for(size_t i = 0; i < len; ++i) {
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+/* Keybindings and configuration structs are stored as they are laid out in
+ * memory, so a snapshot is only used by a build with the same version,
+ * commands and struct sizes */
+static uint64_t
+layout_hash(void) {
+	uint64_t hash = hash_bytes(FNV_OFFSET, CG_VERSION, strlen(CG_VERSION));
+	for(size_t i = 0; i < sizeof(action_names) / sizeof(action_names[0]);
+	    ++i) {
+		hash = hash_bytes(hash, action_names[i], strlen(action_names[i]) + 1);
+	}
+	const size_t sizes[] = {
+	    sizeof(struct keybinding),
+	    sizeof(struct cg_output_config),
+	    sizeof(struct cg_input_config),
+	    sizeof(struct cg_input_config_mapped_from_region),
+	    sizeof(struct cg_message_config),
+	    sizeof(struct cg_overlay_config),
+	    sizeof(struct cg_chord_config),
+	};
+	return hash_bytes(hash, sizes, sizeof(sizes));
+}
+
+static void
+put(struct cg_config_cache *cache, const void *data, size_t len) {
+	if(cache->failed) {
+		return;
+	}
+	if(cache->cap - cache->len < len) {
+		size_t cap = cache->cap == 0 ? 4096 : cache->cap;
+		while(cap - cache->len < len) {
+			cap *= 2;
+		}
+		char *buf = realloc(cache->buf, cap);
+		if(buf == NULL) {
+			wlr_log(WLR_ERROR,
+			        "Failed to allocate memory for configuration cache");
+			cache->failed = true;
+			return;
+		}
+		cache->buf = buf;
+		cache->cap = cap;
+	}
+	memcpy(cache->buf + cache->len, data, len);
+	cache->len += len;
+}
+
+/* Strings are stored with their length, UINT32_MAX for NULL, and the
+ * terminating NUL, such that they can be used in place on load */
+static void
+put_string_len(struct cg_config_cache *cache, const char *str, size_t len) {
+	uint32_t n = str == NULL ? UINT32_MAX : len;
+	put(cache, &n, sizeof(n));
+	if(str != NULL) {
+		put(cache, str, len);
+		put(cache, "", 1);
+	}
+}
+
+static void
+put_string(struct cg_config_cache *cache, const char *str) {
+	put_string_len(cache, str, str == NULL ? 0 : strlen(str));
+}
+
+/* Stores a struct which may be NULL, preceded by whether it is present */
+static void
+put_optional(struct cg_config_cache *cache, const void *data, size_t size) {
+	uint8_t present = data != NULL;
+	put(cache, &present, sizeof(present));
+	if(data != NULL) {
+		put(cache, data, size);
+	}
+}
+
+/* Stores keybinding followed by the data it owns, see keybinding_free */
+static void
+put_keybinding(struct cg_config_cache *cache,
+               const struct keybinding *keybinding) {
+	put_optional(cache, keybinding, sizeof(*keybinding));
+	if(keybinding == NULL) {
+		return;
+	}
+	switch(keybinding->action) {
+	case KEYBINDING_DEFINEMODE:
+	case KEYBINDING_RUN_COMMAND:
+	case KEYBINDING_DISPLAY_MESSAGE:
+	case KEYBINDING_SEND_CUSTOM_EVENT:
+	case KEYBINDING_RECORD:
+	case KEYBINDING_REPLAY:
+		put_string(cache, keybinding->data.c);
+		break;
+	case KEYBINDING_SETMODECURSOR:
+		put_string(cache, keybinding->data.cs[0]);
+		put_string(cache, keybinding->data.cs[1]);
+		break;
+	case KEYBINDING_DEFINEKEY:
+		put_keybinding(cache, keybinding->data.kb);
+		break;
+	case KEYBINDING_CONFIGURE_OUTPUT: {
+		const struct cg_output_config *cfg = keybinding->data.o_cfg;
+		put(cache, cfg, sizeof(*cfg));
+		put_string(cache, cfg->output_name);
+		break;
+	}
+	case KEYBINDING_CONFIGURE_INPUT: {
+		const struct cg_input_config *cfg = keybinding->data.i_cfg;
+		put(cache, cfg, sizeof(*cfg));
+		put_string(cache, cfg->identifier);
+		put_optional(cache, cfg->mapped_from_region,
+		             sizeof(*cfg->mapped_from_region));
+		put_string(cache, cfg->mapped_to_output);
+		break;
+	}
+	case KEYBINDING_CONFIGURE_MESSAGE: {
+		const struct cg_message_config *cfg = keybinding->data.m_cfg;
+		put(cache, cfg, sizeof(*cfg));
+		put_string(cache, cfg->font);
+		break;
+	}
+	case KEYBINDING_OVERLAY: {
+		const struct cg_overlay_config *cfg = keybinding->data.ov_cfg;
+		put(cache, cfg, sizeof(*cfg));
+		put_string(cache, cfg->name);
+		put_string(cache, cfg->text);
+		break;
+	}
+	case KEYBINDING_DEFINECHORD:
+		put(cache, keybinding->data.ch, sizeof(*keybinding->data.ch));
+		put_keybinding(cache, keybinding->data.ch->kb);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool
+get(struct cg_config_cache_reader *reader, void *data, size_t len) {
+	if(reader->failed || (size_t)(reader->end - reader->pos) < len) {
+		reader->failed = true;
+		return false;
+	}
+	memcpy(data, reader->pos, len);
+	reader->pos += len;
+	return true;
+}
+
+/* Returns the next string, which points into the snapshot */
+static char *
+get_string_ref(struct cg_config_cache_reader *reader) {
+	uint32_t len;
+	if(!get(reader, &len, sizeof(len)) || len == UINT32_MAX) {
+		return NULL;
+	}
+	if((size_t)(reader->end - reader->pos) <= len || reader->pos[len] != '\0') {
+		reader->failed = true;
+		return NULL;
+	}
+	char *str = reader->pos;
+	reader->pos += (size_t)len + 1;
+	return str;
+}
+
+static char *
+get_string(struct cg_config_cache_reader *reader) {
+	char *str = get_string_ref(reader);
+	if(str == NULL) {
+		return NULL;
+	}
+	char *copy = strdup(str);
+	if(copy == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for configuration cache");
+		reader->failed = true;
+	}
+	return copy;
+}
+
+static void *
+get_struct(struct cg_config_cache_reader *reader, size_t size) {
+	void *data = malloc(size);
+	if(data == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for configuration cache");
+		reader->failed = true;
+		return NULL;
+	}
+	if(!get(reader, data, size)) {
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+static void *
+get_optional(struct cg_config_cache_reader *reader, size_t size) {
+	uint8_t present;
+	if(!get(reader, &present, sizeof(present)) || !present) {
+		return NULL;
+	}
+	return get_struct(reader, size);
+}
+
+/* Reads a keybinding stored by put_keybinding. The pointers which were
+ * stored with it are replaced before anything else is read, such that a
+ * partially read keybinding can be freed with keybinding_free. */
+static struct keybinding *
+get_keybinding(struct cg_config_cache_reader *reader, int nesting_level) {
+	if(nesting_level >= MAX_NESTING_LEVEL) {
+		reader->failed = true;
+		return NULL;
+	}
+	struct keybinding *keybinding =
+	    get_optional(reader, sizeof(struct keybinding));
+	if(keybinding == NULL) {
+		return NULL;
+	}
+	if((size_t)keybinding->action >=
+	   sizeof(action_names) / sizeof(action_names[0])) {
+		reader->failed = true;
+		free(keybinding);
+		return NULL;
+	}
+	switch(keybinding->action) {
+	case KEYBINDING_DEFINEMODE:
+	case KEYBINDING_RUN_COMMAND:
+	case KEYBINDING_DISPLAY_MESSAGE:
+	case KEYBINDING_SEND_CUSTOM_EVENT:
+	case KEYBINDING_RECORD:
+	case KEYBINDING_REPLAY:
+		keybinding->data.c = get_string(reader);
+		break;
+	case KEYBINDING_SETMODECURSOR:
+		keybinding->data.cs[0] = get_string(reader);
+		keybinding->data.cs[1] = get_string(reader);
+		break;
+	case KEYBINDING_DEFINEKEY:
+		keybinding->data.kb = get_keybinding(reader, nesting_level + 1);
+		break;
+	case KEYBINDING_CONFIGURE_OUTPUT: {
+		struct cg_output_config *cfg = get_struct(reader, sizeof(*cfg));
+		if(cfg == NULL) {
+			free(keybinding);
+			return NULL;
+		}
+		cfg->output_name = get_string(reader);
+		keybinding->data.o_cfg = cfg;
+		break;
+	}
+	case KEYBINDING_CONFIGURE_INPUT: {
+		struct cg_input_config *cfg = get_struct(reader, sizeof(*cfg));
+		if(cfg == NULL) {
+			free(keybinding);
+			return NULL;
+		}
+		// Set by input_config_compile once the configuration is added
+		cfg->match_type = NULL;
+		cfg->identifier = get_string(reader);
+		cfg->mapped_from_region =
+		    get_optional(reader, sizeof(*cfg->mapped_from_region));
+		cfg->mapped_to_output = get_string(reader);
+		keybinding->data.i_cfg = cfg;
+		break;
+	}
+	case KEYBINDING_CONFIGURE_MESSAGE: {
+		struct cg_message_config *cfg = get_struct(reader, sizeof(*cfg));
+		if(cfg == NULL) {
+			free(keybinding);
+			return NULL;
+		}
+		cfg->font = get_string(reader);
+		keybinding->data.m_cfg = cfg;
+		break;
+	}
+	case KEYBINDING_OVERLAY: {
+		struct cg_overlay_config *cfg = get_struct(reader, sizeof(*cfg));
+		if(cfg == NULL) {
+			free(keybinding);
+			return NULL;
+		}
+		cfg->name = get_string(reader);
+		cfg->text = get_string(reader);
+		keybinding->data.ov_cfg = cfg;
+		break;
+	}
+	case KEYBINDING_DEFINECHORD: {
+		struct cg_chord_config *ch = get_struct(reader, sizeof(*ch));
+		if(ch == NULL) {
+			free(keybinding);
+			return NULL;
+		}
+		ch->kb = get_keybinding(reader, nesting_level + 1);
+		keybinding->data.ch = ch;
+		break;
+	}
+	default:
+		break;
+	}
+	if(reader->failed) {
+		keybinding_free(keybinding, true);
+		return NULL;
+	}
+	return keybinding;
+}
+
+static bool
+get_entry(struct cg_config_cache_reader *reader,
+          struct cg_config_cache_entry *entry) {
+	uint8_t type;
+	if(!get(reader, &entry->line, sizeof(entry->line)) ||
+	   !get(reader, &type, sizeof(type))) {
+		return false;
+	}
+	switch(type) {
+	case CG_CONFIG_CACHE_COMMAND:
+		entry->text = get_string_ref(reader);
+		return entry->text != NULL;
+	case CG_CONFIG_CACHE_BINDING:
+		entry->kb = get_keybinding(reader, 0);
+		return entry->kb != NULL;
+	default:
+		reader->failed = true;
+		return false;
+	}
+}
+
+/* Runs the snapshot at path if it was written for the configuration text
+ * by the same build of cagebreak. The keybindings are run without being
+ * parsed, all other lines are parsed again, such that commands like "exec"
+ * and "workspaces" take effect as without the cache. Returns 0 if the
+ * snapshot was run, 1 if there is no usable snapshot, in which case nothing
+ * was run, and -1 if a line cannot be parsed. */
+int
+config_cache_load(struct cg_server *server, const char *path,
+                  const char *text, size_t len) {
+	size_t size;
+	char *buf = read_file(path, &size);
+	if(buf == NULL) {
+		if(errno == ENOENT) {
+			wlr_log(WLR_INFO, "No configuration cache at \"%s\"", path);
+		} else {
+			wlr_log_errno(WLR_ERROR,
+			              "Could not read configuration cache \"%s\"", path);
+		}
+		return 1;
+	}
+	struct cg_config_cache_header header = {0};
+	if(size >= sizeof(header)) {
+		memcpy(&header, buf, sizeof(header));
+	}
+	if(memcmp(header.magic, CG_CONFIG_CACHE_MAGIC, sizeof(header.magic)) !=
+	       0 ||
+	   header.version != CG_CONFIG_CACHE_VERSION ||
+	   header.layout != layout_hash()) {
+		wlr_log(WLR_INFO,
+		        "Configuration cache \"%s\" was written by another version "
+		        "of cagebreak",
+		        path);
+		free(buf);
+		return 1;
+	}
+	if(header.source_len != len ||
+	   header.source != hash_bytes(FNV_OFFSET, text, len)) {
+		wlr_log(WLR_INFO, "Configuration cache \"%s\" is out of date", path);
+		free(buf);
+		return 1;
+	}
+	char *payload = buf + sizeof(header);
+	if(header.payload_len != size - sizeof(header) ||
+	   header.payload != hash_bytes(FNV_OFFSET, payload, header.payload_len) ||
+	   header.nrecords > header.payload_len) {
+		wlr_log(WLR_ERROR, "Configuration cache \"%s\" is corrupt", path);
+		free(buf);
+		return 1;
+	}
+
+	/* All records are decoded before any is run, so that nothing is applied
+	 * twice if the file is parsed after all */
+	struct cg_config_cache_entry *entries = calloc(
+	    (size_t)header.nrecords + 1, sizeof(struct cg_config_cache_entry));
+	if(entries == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for configuration cache");
+		free(buf);
+		return 1;
+	}
+	struct cg_config_cache_reader reader = {
+	    .pos = payload, .end = buf + size, .failed = false};
+	uint32_t n = 0;
+	while(n < header.nrecords && get_entry(&reader, &entries[n])) {
+		++n;
+	}
+	if(n < header.nrecords || reader.pos != reader.end) {
+		wlr_log(WLR_ERROR, "Configuration cache \"%s\" is corrupt", path);
+		for(uint32_t i = 0; i < n; ++i) {
+			if(entries[i].kb != NULL) {
+				keybinding_free(entries[i].kb, true);
+			}
+		}
+		free(entries);
+		free(buf);
+		return 1;
+	}
+
+	int ret = 0;
+	for(uint32_t i = 0; i < n; ++i) {
+		struct cg_config_cache_entry *entry = &entries[i];
+		if(ret != 0) {
+			if(entry->kb != NULL) {
+				keybinding_free(entry->kb, true);
+			}
+		} else if(entry->kb != NULL) {
+			run_action(entry->kb->action, server, entry->kb->data);
+			keybinding_free(entry->kb, false);
+		} else {
+			char *errstr = NULL;
+			if(parse_rc_line(server, entry->text, &errstr) != 0) {
+				wlr_log(WLR_ERROR,
+				        "Error in line %u of cached configuration \"%s\"",
+				        entry->line, path);
+				free(errstr);
+				ret = -1;
+			}
+		}
+	}
+	free(entries);
+	free(buf);
+	if(ret == 0) {
+		wlr_log(WLR_INFO, "Loaded %u commands from configuration cache \"%s\"",
+		        n, path);
+	}
+	return ret;
+}
+
+struct cg_config_cache *
+config_cache_create(const char *text, size_t len) {
+	struct cg_config_cache *cache = calloc(1, sizeof(struct cg_config_cache));
+	if(cache == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for configuration cache");
+		return NULL;
+	}
+	cache->source = hash_bytes(FNV_OFFSET, text, len);
+	cache->source_len = len;
+	return cache;
+}
+
+/* Parses and runs line like parse_rc_line and appends it to cache. Since line
+ * is tokenized in place, text is a copy of it which is not modified. */
+int
+config_cache_parse_line(struct cg_server *server,
+                        struct cg_config_cache *cache, uint32_t line_num,
+                        char *line, const char *text, size_t text_len,
+                        char **errstr) {
+	struct keybinding *keybinding = malloc(sizeof(struct keybinding));
+	if(keybinding == NULL) {
+		wlr_log(WLR_ERROR,
+		        "Failed to allocate memory for temporary keybinding struct.");
+		return -1;
+	}
+	if(parse_command(server, keybinding, line, errstr, 1) != 0) {
+		wlr_log(WLR_ERROR, "Error parsing command.");
+		free(keybinding);
+		return -1;
+	}
+	/* The mode index of "definekey" refers to the modes defined before */
+	uint8_t type = keybinding->action == KEYBINDING_DEFINEMODE ||
+	                       reload_is_declarative(keybinding)
+	                   ? CG_CONFIG_CACHE_BINDING
+	                   : CG_CONFIG_CACHE_COMMAND;
+	put(cache, &line_num, sizeof(line_num));
+	put(cache, &type, sizeof(type));
+	if(type == CG_CONFIG_CACHE_BINDING) {
+		put_keybinding(cache, keybinding);
+	} else {
+		put_string_len(cache, text, text_len);
+	}
+	++cache->nrecords;
+	run_action(keybinding->action, server, keybinding->data);
+	keybinding_free(keybinding, false);
+	return 0;
+}
+
+/* Writes the snapshot to path. It is written to a temporary file first,
+ * which then replaces path, so that a crash never leaves a partial
+ * snapshot. */
+void
+config_cache_save(const struct cg_config_cache *cache, const char *path) {
+	if(cache->failed) {
+		return;
+	}
+	struct cg_config_cache_header header = {
+	    .version = CG_CONFIG_CACHE_VERSION,
+	    .nrecords = cache->nrecords,
+	    .layout = layout_hash(),
+	    .source = cache->source,
+	    .source_len = cache->source_len,
+	    .payload = hash_bytes(FNV_OFFSET, cache->buf, cache->len),
+	    .payload_len = cache->len,
+	};
+	memcpy(header.magic, CG_CONFIG_CACHE_MAGIC, sizeof(header.magic));
+	char *tmp_path = malloc_vsprintf("%s.tmp", path);
+	if(tmp_path == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for configuration cache");
+		return;
+	}
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	FILE *file = fd < 0 ? NULL : fdopen(fd, "wb");
+	if(file == NULL) {
+		wlr_log_errno(WLR_ERROR, "Unable to create \"%s\"", tmp_path);
+		if(fd >= 0) {
+			close(fd);
+		}
+		free(tmp_path);
+		return;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+	          (cache->len == 0 || fwrite(cache->buf, cache->len, 1, file) == 1);
+	if(fclose(file) != 0) {
+		ok = false;
+	}
+	if(!ok || rename(tmp_path, path) != 0) {
+		wlr_log_errno(WLR_ERROR, "Unable to write configuration cache \"%s\"",
+		              path);
+		unlink(tmp_path);
+	} else {
+		wlr_log(WLR_INFO, "Wrote configuration cache \"%s\"", path);
+	}
+	free(tmp_path);
+}
+
+void
+config_cache_destroy(struct cg_config_cache *cache) {
+	if(cache == NULL) {
+		return;
+	}
+	free(cache->buf);
+	free(cache);
+}
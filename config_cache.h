@@ -0,0 +1,45 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_CONFIG_CACHE_H
+#define CG_CONFIG_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct cg_server;
+
+#define CG_CONFIG_CACHE_MAGIC "CGCFGCAC"
+/* Increased whenever the encoding of the records changes */
+#define CG_CONFIG_CACHE_VERSION 1
+
+/* Snapshot of a configuration file, written while the file is parsed. The
+ * commands compared by "reload" (see reload_is_declarative) and "definemode"
+ * are stored as parsed keybindings, all other lines as text. */
+struct cg_config_cache {
+	uint64_t source;     // Hash of the configuration file
+	uint64_t source_len; // Length of the configuration file
+	uint32_t nrecords;
+	char *buf;
+	size_t len;
+	size_t cap;
+	bool failed; // An allocation failed, the snapshot is not written
+};
+
+int
+config_cache_load(struct cg_server *server, const char *path,
+                  const char *text, size_t len);
+struct cg_config_cache *
+config_cache_create(const char *text, size_t len);
+int
+config_cache_parse_line(struct cg_server *server,
+                        struct cg_config_cache *cache, uint32_t line_num,
+                        char *line, const char *text, size_t text_len,
+                        char **errstr);
+void
+config_cache_save(const struct cg_config_cache *cache, const char *path);
+void
+config_cache_destroy(struct cg_config_cache *cache);
+
+#endif
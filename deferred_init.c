@@ -0,0 +1,128 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include "config.h"
+
+#include <cairo/cairo.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_cursor.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_xcursor_manager.h>
+#include <wlr/util/log.h>
+
+#include "deferred_init.h"
+#include "output.h"
+#include "pango.h"
+#include "seat.h"
+#include "server.h"
+#include "startup_trace.h"
+#include "util.h"
+#if CG_HAS_XWAYLAND
+#include "xwayland.h"
+#endif
+
+static void
+load_cursor_themes(struct cg_server *server) {
+	struct wlr_xcursor_manager *manager = server->seat->xcursor_manager;
+	struct cg_output *output;
+	wl_list_for_each(output, &server->outputs, link) {
+		if(!wlr_xcursor_manager_load(manager, output->wlr_output->scale)) {
+			wlr_log(WLR_ERROR,
+			        "Cannot load XCursor theme for output '%s' with scale %f",
+			        output->name, output->wlr_output->scale);
+		}
+	}
+	wl_list_for_each(output, &server->disabled_outputs, link) {
+		wlr_xcursor_manager_load(manager, output->wlr_output->scale);
+	}
+	/* Draw the image which was requested while the themes were missing, but
+	 * leave a cursor surface of a client alone. Setting the same name again
+	 * is ignored by wlr_cursor, so the image is unset first. */
+	struct cg_seat *seat = server->seat;
+	if(seat->xcursor != NULL) {
+		char *name = seat->xcursor;
+		seat->xcursor = NULL;
+		wlr_cursor_unset_image(seat->cursor);
+		seat_set_xcursor(seat, name);
+		free(name);
+	}
+}
+
+#if CG_HAS_XWAYLAND
+static void
+load_xwayland_cursor(struct cg_server *server) {
+	if(server->xwayland != NULL) {
+		xwayland_set_default_cursor(server);
+	}
+}
+#endif
+
+/* Lays out a string in the message font, which initializes fontconfig and
+ * loads the font before the first message is shown */
+static void
+warm_font_cache(struct cg_server *server) {
+	cairo_surface_t *surface =
+	    cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 0, 0);
+	if(surface == NULL) {
+		return;
+	}
+	cairo_t *cairo = cairo_create(surface);
+	int width = 0, height = 0;
+	get_text_size(cairo, server->message_config.font, &width, &height, NULL,
+	              1, "%s", "cagebreak");
+	cairo_destroy(cairo);
+	cairo_surface_destroy(surface);
+}
+
+static const struct {
+	const char *name;
+	void (*run)(struct cg_server *server);
+} deferred_steps[] = {
+    {"cursor_themes", load_cursor_themes},
+#if CG_HAS_XWAYLAND
+    {"xwayland_cursor", load_xwayland_cursor},
+#endif
+    {"font_cache", warm_font_cache},
+};
+
+#define DEFERRED_STEPS (sizeof(deferred_steps) / sizeof(deferred_steps[0]))
+
+/* Runs one step per idle callback, such that input and frames are handled
+ * in between */
+static void
+handle_deferred_init(void *data) {
+	struct cg_server *server = data;
+	server->deferred_init = NULL;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	deferred_steps[server->deferred_init_step].run(server);
+	startup_trace_span(server, deferred_steps[server->deferred_init_step].name,
+	                   timespec_to_ns(&start));
+
+	if(++server->deferred_init_step < DEFERRED_STEPS) {
+		deferred_init_schedule(server);
+		return;
+	}
+	server->defer_init = false;
+	startup_trace_milestone(server, CG_STARTUP_DEFERRED_INIT);
+}
+
+/* Continues the initialization which was deferred until the first frame
+ * was presented */
+void
+deferred_init_schedule(struct cg_server *server) {
+	if(!server->defer_init || server->deferred_init != NULL) {
+		return;
+	}
+	server->deferred_init = wl_event_loop_add_idle(
+	    server->event_loop, handle_deferred_init, server);
+	if(server->deferred_init == NULL) {
+		wlr_log(WLR_ERROR, "Failed to schedule deferred initialization");
+	}
+}
@@ -0,0 +1,12 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_DEFERRED_INIT_H
+#define CG_DEFERRED_INIT_H
+
+struct cg_server;
+
+void
+deferred_init_schedule(struct cg_server *server);
+
+#endif
@@ -0,0 +1,190 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+
+#include "frame_stats.h"
+#include "ipc_server.h"
+#include "output.h"
+#include "server.h"
+#include "util.h"
+
+void
+frame_stats_init(struct cg_frame_stats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	stats->pending_present = -1;
+}
+
+void
+frame_stats_record(struct cg_frame_stats *stats,
+                   const struct cg_frame_sample *sample) {
+	if(stats->pending_present == (int32_t)stats->head) {
+		stats->pending_present = -1;
+	}
+	stats->samples[stats->head] = *sample;
+	if(!sample->skipped) {
+		stats->pending_present = stats->head;
+	}
+	stats->head = (stats->head + 1) % CG_FRAME_STATS_SAMPLES;
+	if(stats->count < CG_FRAME_STATS_SAMPLES) {
+		++stats->count;
+	}
+}
+
+void
+frame_stats_presented(struct cg_frame_stats *stats, uint64_t when_ns) {
+	if(stats->pending_present < 0) {
+		return;
+	}
+	struct cg_frame_sample *sample = &stats->samples[stats->pending_present];
+	uint64_t commit_end = sample->frame_ns + sample->to_commit_ns;
+	if(when_ns > commit_end) {
+		sample->present_ns = when_ns - commit_end;
+	}
+	stats->pending_present = -1;
+}
+
+/* Predicts the duration of the next commit as the longest commit of the most
+ * recent drawn frames. Returns 0 if there is no such frame yet. */
+uint64_t
+frame_stats_predict_commit(const struct cg_frame_stats *stats) {
+	uint64_t max = 0;
+	uint32_t seen = 0;
+	for(uint32_t i = 1; i <= stats->count && seen < CG_FRAME_STATS_PREDICT;
+	    ++i) {
+		const struct cg_frame_sample *sample =
+		    &stats->samples[(stats->head + CG_FRAME_STATS_SAMPLES - i) %
+		                    CG_FRAME_STATS_SAMPLES];
+		if(sample->skipped) {
+			continue;
+		}
+		++seen;
+		if(sample->commit_ns > max) {
+			max = sample->commit_ns;
+		}
+	}
+	return max;
+}
+
+static int
+compare_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* Sorts values in place and returns the p-th percentile in microseconds */
+static uint64_t
+percentile_us(uint64_t *values, uint32_t n, uint32_t p) {
+	if(n == 0) {
+		return 0;
+	}
+	return values[(uint64_t)(n - 1) * p / 100] / 1000;
+}
+
+static char *
+print_percentiles(const char *name, uint64_t *values, uint32_t n) {
+	qsort(values, n, sizeof(uint64_t), compare_u64);
+	return malloc_vsprintf("\"%s\":{\"p50\":%" PRIu64 ",\"p95\":%" PRIu64
+	                       ",\"p99\":%" PRIu64 "}",
+	                       name, percentile_us(values, n, 50),
+	                       percentile_us(values, n, 95),
+	                       percentile_us(values, n, 99));
+}
+
+void
+frame_stats_send(struct cg_output *output) {
+	const struct cg_frame_stats *stats = &output->frame_stats;
+	uint64_t commit[CG_FRAME_STATS_SAMPLES];
+	uint64_t to_commit[CG_FRAME_STATS_SAMPLES];
+	uint64_t present[CG_FRAME_STATS_SAMPLES];
+	uint32_t drawn = 0, presented = 0;
+
+	uint32_t first =
+	    (stats->head + CG_FRAME_STATS_SAMPLES - stats->count) %
+	    CG_FRAME_STATS_SAMPLES;
+	for(uint32_t i = 0; i < stats->count; ++i) {
+		const struct cg_frame_sample *sample =
+		    &stats->samples[(first + i) % CG_FRAME_STATS_SAMPLES];
+		if(sample->skipped) {
+			continue;
+		}
+		commit[drawn] = sample->commit_ns;
+		to_commit[drawn] = sample->to_commit_ns;
+		++drawn;
+		if(sample->present_ns != 0) {
+			present[presented++] = sample->present_ns;
+		}
+	}
+
+	double fps = 0, idle_ratio = 0;
+	if(stats->count > 1) {
+		uint64_t oldest = stats->samples[first].frame_ns;
+		uint64_t newest =
+		    stats->samples[(first + stats->count - 1) % CG_FRAME_STATS_SAMPLES]
+		        .frame_ns;
+		/* The oldest frame only starts the measured time span */
+		uint32_t after_oldest = drawn - !stats->samples[first].skipped;
+		if(newest > oldest) {
+			fps = after_oldest * 1e9 / (newest - oldest);
+		}
+	}
+	if(stats->count > 0) {
+		idle_ratio = (double)(stats->count - drawn) / stats->count;
+	}
+
+	char *commit_str = print_percentiles("commit_us", commit, drawn);
+	char *to_commit_str =
+	    print_percentiles("frame_to_commit_us", to_commit, drawn);
+	char *present_str = print_percentiles("present_us", present, presented);
+	if(commit_str == NULL || to_commit_str == NULL || present_str == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for frame statistics");
+	} else {
+		ipc_send_event(output->server,
+		               "{\"event_name\":\"stats\",\"output\":\"%s\","
+		               "\"output_id\":%d,\"frames\":%" PRIu32
+		               ",\"skipped\":%" PRIu32 ",\"fps\":%f,"
+		               "\"idle_ratio\":%f,%s,%s,%s}",
+		               output->name, output_get_num(output), stats->count,
+		               stats->count - drawn, fps, idle_ratio, commit_str,
+		               to_commit_str, present_str);
+	}
+	free(commit_str);
+	free(to_commit_str);
+	free(present_str);
+}
+
+static int
+handle_stats_stream(void *data) {
+	struct cg_server *server = data;
+	struct cg_output *output;
+	wl_list_for_each(output, &server->outputs, link) {
+		if(!output->destroyed) {
+			frame_stats_send(output);
+		}
+	}
+	wl_event_source_timer_update(server->stats_stream,
+	                             server->stats_interval * 1000);
+	return 0;
+}
+
+/* Send the statistics of all outputs every interval seconds, 0 stops it */
+void
+frame_stats_set_stream(struct cg_server *server, uint32_t interval) {
+	server->stats_interval = interval;
+	if(server->stats_stream == NULL) {
+		if(interval == 0) {
+			return;
+		}
+		server->stats_stream = wl_event_loop_add_timer(
+		    server->event_loop, handle_stats_stream, server);
+		if(server->stats_stream == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create timer for statistics");
+			return;
+		}
+	}
+	wl_event_source_timer_update(server->stats_stream, interval * 1000);
+}
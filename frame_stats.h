@@ -0,0 +1,48 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_FRAME_STATS_H
+#define CG_FRAME_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct cg_output;
+struct cg_server;
+
+#define CG_FRAME_STATS_SAMPLES 256
+// Number of drawn frames considered when predicting the commit duration
+#define CG_FRAME_STATS_PREDICT 16
+
+struct cg_frame_sample {
+	uint64_t frame_ns;     // CLOCK_MONOTONIC time of the frame event
+	uint64_t commit_ns;    // Duration of the scene output commit
+	uint64_t to_commit_ns; // Time from the frame event to the end of the commit
+	uint64_t present_ns;   // Time from the end of the commit to presentation,
+	                       // 0 if no presentation feedback was received
+	bool skipped;          // The frame had no damage, nothing was drawn
+};
+
+/* Ring buffer of the timings of the most recent frames of an output */
+struct cg_frame_stats {
+	struct cg_frame_sample samples[CG_FRAME_STATS_SAMPLES];
+	uint32_t head;  // Index of the slot the next sample is written to
+	uint32_t count; // Number of valid samples
+	int32_t pending_present; // Sample awaiting presentation, -1 if none
+};
+
+void
+frame_stats_init(struct cg_frame_stats *stats);
+void
+frame_stats_record(struct cg_frame_stats *stats,
+                   const struct cg_frame_sample *sample);
+void
+frame_stats_presented(struct cg_frame_stats *stats, uint64_t when_ns);
+uint64_t
+frame_stats_predict_commit(const struct cg_frame_stats *stats);
+void
+frame_stats_send(struct cg_output *output);
+void
+frame_stats_set_stream(struct cg_server *server, uint32_t interval);
+
+#endif
@@ -5,6 +5,7 @@
 #define _GNU_SOURCE
 #include <cairo.h>
 #include <cairo/cairo.h>
+#include <spawn.h>
 #include <stdlib.h>
 
 int
@@ -12,6 +13,24 @@ fork(void) {
 	return 1;
 }
 
+int
+posix_spawn(pid_t *pid, const char *path,
+            const posix_spawn_file_actions_t *file_actions,
+            const posix_spawnattr_t *attrp, char *const argv[],
+            char *const envp[]) {
+	*pid = 1;
+	return 0;
+}
+
+int
+posix_spawnp(pid_t *pid, const char *file,
+             const posix_spawn_file_actions_t *file_actions,
+             const posix_spawnattr_t *attrp, char *const argv[],
+             char *const envp[]) {
+	*pid = 1;
+	return 0;
+}
+
 void
 wlr_texture_get_size(struct wlr_texture *texture, int *width, int *height) {
 	if(width != NULL) {
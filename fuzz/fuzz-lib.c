@@ -45,6 +45,7 @@
 #include <wlr/xwayland.h>
 #endif
 
+#include "../chord.h"
 #include "../idle_inhibit_v1.h"
 #include "../input_manager.h"
 #include "../keybinding.h"
@@ -52,6 +53,7 @@
 #include "../parse.h"
 #include "../seat.h"
 #include "../server.h"
+#include "../spawn.h"
 #include "../xdg_shell.h"
 #if CG_HAS_XWAYLAND
 #include "../xwayland.h"
@@ -104,6 +106,8 @@ cleanup(void) {
 	free(server.modes);
 
 	keybinding_list_free(server.keybindings);
+	chord_free(server.chords);
+	spawn_finish(&server);
 
 	if(server.seat != NULL) {
 		seat_destroy(server.seat);
@@ -135,6 +139,9 @@ LLVMFuzzerInitialize(int *argc, char ***argv) {
 	wl_list_init(&server.output_priorities);
 	wl_list_init(&server.outputs);
 	wl_list_init(&server.disabled_outputs);
+	wl_list_init(&server.children);
+	wl_list_init(&server.stopped_replays);
+	wl_list_init(&server.launch_stats);
 
 	int ret = 0;
 
@@ -196,6 +203,7 @@ LLVMFuzzerInitialize(int *argc, char ***argv) {
 	}
 
 	server.nws = 1;
+	server.idle_interval = 100;
 	server.views_curr_id = 1;
 	server.tiles_curr_id = 1;
 	server.message_config.fg_color[0] = 0.0;
@@ -243,6 +251,13 @@ LLVMFuzzerInitialize(int *argc, char ***argv) {
 		goto end;
 	}
 
+	server.chords = chord_create();
+	if(server.chords == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate chords");
+		ret = 1;
+		goto end;
+	}
+
 	server.renderer = wlr_renderer_autocreate(backend);
 	if(!server.renderer) {
 		wlr_log(WLR_ERROR, "Unable to create the wlroots renderer");
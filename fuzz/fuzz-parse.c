@@ -11,6 +11,7 @@
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/util/log.h>
 
+#include "../chord.h"
 #include "../keybinding.h"
 #include "../message.h"
 #include "../output.h"
@@ -57,6 +58,9 @@ LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
 	free(str);
 	keybinding_list_free(server.keybindings);
 	server.keybindings = keybinding_list_init();
+	chord_free(server.chords);
+	server.chords = chord_create();
+	seat_reset_chord(server.seat);
 	run_action(KEYBINDING_WORKSPACES, &server,
 	           (union keybinding_params){.i = 1});
 	run_action(KEYBINDING_LAYOUT_FULLSCREEN, &server,
@@ -91,6 +95,7 @@ LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
 	cfg->priority = -1;
 	cfg->scale = 1;
 	cfg->angle = 0;
+	cfg->max_render_time = 0;
 
 	wl_list_for_each(output, &server.outputs, link) {
 		output_apply_config(&server, output, cfg);
@@ -6,6 +6,7 @@
 #include <wlr/types/wlr_idle_notify_v1.h>
 
 #include "idle_inhibit_v1.h"
+#include "seat.h"
 #include "server.h"
 
 struct cg_idle_inhibitor_v1 {
@@ -21,6 +22,11 @@ idle_inhibit_v1_check_active(struct cg_server *server) {
 	 * is visible or not.*/
 	bool inhibited = !wl_list_empty(&server->inhibitors);
 	wlr_idle_notifier_v1_set_inhibited(server->idle, inhibited);
+	/* Input activity is throttled, make sure the first event after a change
+	 * of the inhibition state reaches the idle notifier */
+	if(server->seat != NULL) {
+		seat_reset_activity(server->seat);
+	}
 }
 
 static void
@@ -1,4 +1,4 @@
-// Copyright 2020 - 2025, project-repo and the cagebreak contributors
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
 // SPDX-License-Identifier: MIT
 
 #ifndef _CG_INPUT_H
@@ -19,4 +19,7 @@ cg_input_apply_config(struct cg_input_config *config, struct cg_server *server);
 bool
 cg_libinput_device_is_builtin(struct cg_input_device *device);
 
+const char *
+input_device_get_type(struct cg_input_device *device);
+
 #endif
@@ -94,6 +94,7 @@ input_manager_handle_device_destroy(struct wl_listener *listener,
 	wl_list_remove(&input_device->link);
 	wl_list_remove(&input_device->device_destroy.link);
 	free(input_device->identifier);
+	free(input_device->config);
 	free(input_device);
 }
 
@@ -133,119 +134,191 @@ input_manager_create_empty_input_config(void) {
 	return cfg;
 }
 
-/* cfg1 has precedence */
-struct cg_input_config *
-input_manager_merge_input_configs(struct cg_input_config *cfg1,
-                                  struct cg_input_config *cfg2) {
-	struct cg_input_config *out_cfg = calloc(1, sizeof(struct cg_input_config));
-	if(cfg1->identifier == NULL) {
-		if(cfg2->identifier != NULL) {
-			out_cfg->identifier = strdup(cfg2->identifier);
-		}
-	} else {
-		out_cfg->identifier = strdup(cfg1->identifier);
+/* Sets all fields of cfg which are unset to their value in from */
+static void
+input_config_inherit(struct cg_input_config *cfg,
+                     const struct cg_input_config *from) {
+	if(cfg->tap == INT_MIN) {
+		cfg->tap = from->tap;
 	}
-	if(out_cfg == NULL) {
-		return NULL;
+	if(cfg->send_events == INT_MIN) {
+		cfg->send_events = from->send_events;
 	}
-	if(cfg1->tap == INT_MIN) {
-		out_cfg->tap = cfg2->tap;
-	} else {
-		out_cfg->tap = cfg1->tap;
+	if(cfg->dwt == INT_MIN) {
+		cfg->dwt = from->dwt;
 	}
-	if(cfg1->send_events == INT_MIN) {
-		out_cfg->send_events = cfg2->send_events;
-	} else {
-		out_cfg->send_events = cfg1->send_events;
+	if(cfg->drag_lock == INT_MIN) {
+		cfg->drag_lock = from->drag_lock;
 	}
-	if(cfg1->dwt == INT_MIN) {
-		out_cfg->dwt = cfg2->dwt;
-	} else {
-		out_cfg->dwt = cfg1->dwt;
+	if(cfg->drag == INT_MIN) {
+		cfg->drag = from->drag;
 	}
-	if(cfg1->drag_lock == INT_MIN) {
-		out_cfg->drag_lock = cfg2->drag_lock;
-	} else {
-		out_cfg->drag_lock = cfg1->drag_lock;
+	if(cfg->tap_button_map == INT_MIN) {
+		cfg->tap_button_map = from->tap_button_map;
 	}
-	if(cfg1->drag == INT_MIN) {
-		out_cfg->drag = cfg2->drag;
-	} else {
-		out_cfg->drag = cfg1->drag;
+	if(cfg->left_handed == INT_MIN) {
+		cfg->left_handed = from->left_handed;
 	}
-	if(cfg1->tap_button_map == INT_MIN) {
-		out_cfg->tap_button_map = cfg2->tap_button_map;
-	} else {
-		out_cfg->tap_button_map = cfg1->tap_button_map;
+	if(cfg->scroll_method == INT_MIN) {
+		cfg->scroll_method = from->scroll_method;
 	}
-	if(cfg1->left_handed == INT_MIN) {
-		out_cfg->left_handed = cfg2->left_handed;
-	} else {
-		out_cfg->left_handed = cfg1->left_handed;
+	if(cfg->scroll_button == INT_MIN) {
+		cfg->scroll_button = from->scroll_button;
 	}
-	if(cfg1->scroll_method == INT_MIN) {
-		out_cfg->scroll_method = cfg2->scroll_method;
-	} else {
-		out_cfg->scroll_method = cfg1->scroll_method;
+	if(cfg->scroll_factor == FLT_MIN) {
+		cfg->scroll_factor = from->scroll_factor;
 	}
-	if(cfg1->scroll_button == INT_MIN) {
-		out_cfg->scroll_button = cfg2->scroll_button;
-	} else {
-		out_cfg->scroll_button = cfg1->scroll_button;
+	if(cfg->pointer_accel == FLT_MIN) {
+		cfg->pointer_accel = from->pointer_accel;
 	}
-	if(cfg1->scroll_factor == FLT_MIN) {
-		out_cfg->scroll_factor = cfg2->scroll_factor;
-	} else {
-		out_cfg->scroll_factor = cfg1->scroll_factor;
+	if(cfg->accel_profile == INT_MIN) {
+		cfg->accel_profile = from->accel_profile;
 	}
-	if(cfg1->pointer_accel == FLT_MIN) {
-		out_cfg->pointer_accel = cfg2->pointer_accel;
-	} else {
-		out_cfg->pointer_accel = cfg1->pointer_accel;
+	if(cfg->natural_scroll == INT_MIN) {
+		cfg->natural_scroll = from->natural_scroll;
 	}
-	if(cfg1->accel_profile == INT_MIN) {
-		out_cfg->accel_profile = cfg2->accel_profile;
-	} else {
-		out_cfg->accel_profile = cfg1->accel_profile;
+	if(cfg->middle_emulation == INT_MIN) {
+		cfg->middle_emulation = from->middle_emulation;
 	}
-	if(cfg1->natural_scroll == INT_MIN) {
-		out_cfg->natural_scroll = cfg2->natural_scroll;
-	} else {
-		out_cfg->natural_scroll = cfg1->natural_scroll;
+	if(cfg->click_method == INT_MIN) {
+		cfg->click_method = from->click_method;
 	}
-	if(cfg1->middle_emulation == INT_MIN) {
-		out_cfg->middle_emulation = cfg2->middle_emulation;
-	} else {
-		out_cfg->middle_emulation = cfg1->middle_emulation;
+	if(cfg->enable_keybindings == -1) {
+		cfg->enable_keybindings = from->enable_keybindings;
 	}
-	if(cfg1->click_method == INT_MIN) {
-		out_cfg->click_method = cfg2->click_method;
-	} else {
-		out_cfg->click_method = cfg1->click_method;
+	if(cfg->repeat_delay == -1) {
+		cfg->repeat_delay = from->repeat_delay;
 	}
-	if(cfg1->enable_keybindings == -1) {
-		out_cfg->enable_keybindings = cfg2->enable_keybindings;
-	} else {
-		out_cfg->enable_keybindings = cfg1->enable_keybindings;
+	if(cfg->repeat_rate == -1) {
+		cfg->repeat_rate = from->repeat_rate;
 	}
-	if(cfg1->repeat_delay == -1) {
-		out_cfg->repeat_delay = cfg2->repeat_delay;
-	} else {
-		out_cfg->repeat_delay = cfg1->repeat_delay;
+	if(cfg->calibration_matrix.configured == false) {
+		cfg->calibration_matrix = from->calibration_matrix;
+	}
+}
+
+/* cfg1 has precedence */
+struct cg_input_config *
+input_manager_merge_input_configs(struct cg_input_config *cfg1,
+                                  struct cg_input_config *cfg2) {
+	struct cg_input_config *out_cfg = input_manager_create_empty_input_config();
+	if(out_cfg == NULL) {
+		return NULL;
 	}
-	if(cfg1->repeat_rate == -1) {
-		out_cfg->repeat_rate = cfg2->repeat_rate;
+	if(cfg1->identifier == NULL) {
+		if(cfg2->identifier != NULL) {
+			out_cfg->identifier = strdup(cfg2->identifier);
+		}
 	} else {
-		out_cfg->repeat_rate = cfg1->repeat_rate;
+		out_cfg->identifier = strdup(cfg1->identifier);
 	}
-	if(cfg1->calibration_matrix.configured == false) {
-		out_cfg->calibration_matrix = cfg2->calibration_matrix;
+	input_config_inherit(out_cfg, cfg1);
+	input_config_inherit(out_cfg, cfg2);
+	return out_cfg;
+}
+
+static void
+input_config_compile(struct cg_input_config *config) {
+	if(strcmp(config->identifier, "*") == 0) {
+		config->match = CG_INPUT_MATCH_ALL;
+	} else if(strncmp(config->identifier, "type:", 5) == 0) {
+		config->match = CG_INPUT_MATCH_TYPE;
+		config->match_type = config->identifier + 5;
 	} else {
-		out_cfg->calibration_matrix = cfg1->calibration_matrix;
+		config->match = CG_INPUT_MATCH_IDENTIFIER;
+	}
+}
+
+bool
+input_config_matches(const struct cg_input_config *config,
+                     const char *identifier, const char *type) {
+	switch(config->match) {
+	case CG_INPUT_MATCH_ALL:
+		return true;
+	case CG_INPUT_MATCH_TYPE:
+		return strcmp(config->match_type, type) == 0;
+	case CG_INPUT_MATCH_IDENTIFIER:
+		return identifier != NULL &&
+		       strcmp(config->identifier, identifier) == 0;
+	default:
+		return false;
+	}
+}
+
+/* Merges all configurations matching a device into a new configuration. A
+ * configuration for the identifier of the device has precedence over one for
+ * its type, which has precedence over one for all devices. Among those of the
+ * same kind, the most recent one has precedence. */
+struct cg_input_config *
+input_manager_effective_config(struct cg_server *server,
+                               const char *identifier, const char *type) {
+	struct cg_input_config *out_cfg = input_manager_create_empty_input_config();
+	if(out_cfg == NULL) {
+		return NULL;
+	}
+	for(int match = CG_INPUT_MATCH_COUNT - 1; match >= 0; --match) {
+		struct cg_input_config *config;
+		/* The list is ordered from the most recent to the oldest */
+		wl_list_for_each(config, &server->input_config, link) {
+			if((int)config->match == match &&
+			   input_config_matches(config, identifier, type)) {
+				input_config_inherit(out_cfg, config);
+			}
+		}
 	}
 	return out_cfg;
 }
 
+/* Stores a copy of config without applying it, returns the copy */
+struct cg_input_config *
+input_manager_insert_input_config(struct cg_server *server,
+                                  struct cg_input_config *config) {
+	struct cg_input_config *tcfg = input_manager_create_empty_input_config();
+	if(tcfg == NULL) {
+		wlr_log(WLR_ERROR,
+		        "Could not allocate temporary empty input configuration.");
+		return NULL;
+	}
+	struct cg_input_config *ocfg =
+	    input_manager_merge_input_configs(config, tcfg);
+	free(tcfg);
+	if(ocfg == NULL || ocfg->identifier == NULL) {
+		wlr_log(WLR_ERROR,
+		        "Could not allocate input configuration for merging.");
+		free(ocfg);
+		return NULL;
+	}
+	input_config_compile(ocfg);
+	wl_list_insert(&server->input_config, &ocfg->link);
+	return ocfg;
+}
+
+/* Removes all stored configurations for identifier without reconfiguring
+ * the devices */
+void
+input_manager_remove_input_configs(struct cg_server *server,
+                                   const char *identifier) {
+	struct cg_input_config *config, *tmp;
+	wl_list_for_each_safe(config, tmp, &server->input_config, link) {
+		if(strcmp(config->identifier, identifier) == 0) {
+			wl_list_remove(&config->link);
+			free(config->identifier);
+			free(config);
+		}
+	}
+}
+
+/* Adds a copy of config and reconfigures the devices it applies to */
+void
+input_manager_add_input_config(struct cg_server *server,
+                               struct cg_input_config *config) {
+	struct cg_input_config *ocfg =
+	    input_manager_insert_input_config(server, config);
+	if(ocfg != NULL) {
+		cg_input_manager_configure(server, ocfg);
+	}
+}
+
 void
 apply_keyboard_group_config(struct cg_input_config *config,
                             struct cg_keyboard_group *group) {
@@ -266,47 +339,44 @@ apply_keyboard_group_config(struct cg_input_config *config,
 void
 cg_input_manager_configure_keyboard_group(struct cg_keyboard_group *group) {
 	struct cg_server *server = group->seat->server;
-	struct cg_input_config *tot_cfg = input_manager_create_empty_input_config();
-	if(tot_cfg == NULL) {
+	struct cg_input_config *config =
+	    input_manager_effective_config(server, group->identifier, "keyboard");
+	if(config == NULL) {
 		return;
 	}
 
-	struct cg_input_config *tmp_cfg, *config = NULL;
-	wl_list_for_each(config, &server->input_config, link) {
-		if(strcmp(config->identifier, group->identifier) == 0 ||
-		   strcmp(config->identifier, "*") == 0 ||
-		   (strncmp(config->identifier, "type:", 5) == 0 &&
-		    strcmp(config->identifier + 5, "keyboard") == 0)) {
-			tmp_cfg = tot_cfg;
-			if(tot_cfg->identifier == NULL ||
-			   strcmp(tot_cfg->identifier, "*") == 0 ||
-			   strcmp(config->identifier, group->identifier)) {
-				tot_cfg = input_manager_merge_input_configs(config, tot_cfg);
-			} else {
-				tot_cfg = input_manager_merge_input_configs(tot_cfg, config);
-			}
-			if(tmp_cfg->identifier != NULL) {
-				free(tmp_cfg->identifier);
-			}
-			free(tmp_cfg);
-		}
-	}
-	apply_keyboard_group_config(tot_cfg, group);
-	if(tot_cfg->identifier != NULL) {
-		free(tot_cfg->identifier);
+	struct cg_input_config *old = group->config;
+	if(old != NULL &&
+	   old->enable_keybindings == config->enable_keybindings &&
+	   old->repeat_delay == config->repeat_delay &&
+	   old->repeat_rate == config->repeat_rate) {
+		free(config);
+		return;
 	}
-	free(tot_cfg);
+	apply_keyboard_group_config(config, group);
+	free(old);
+	group->config = config;
 }
 
+/* Reconfigures the devices changed applies to, or all devices if changed is
+ * NULL. Devices whose effective configuration stays the same are left
+ * untouched. */
 void
-cg_input_manager_configure(struct cg_server *server) {
+cg_input_manager_configure(struct cg_server *server,
+                           const struct cg_input_config *changed) {
 	struct cg_input_device *device = NULL;
 	wl_list_for_each(device, &server->input->devices, link) {
-		cg_input_configure_libinput_device(device);
+		if(changed == NULL ||
+		   input_config_matches(changed, device->identifier, device->type)) {
+			cg_input_configure_libinput_device(device);
+		}
 	}
 	struct cg_keyboard_group *group = NULL;
 	wl_list_for_each(group, &server->seat->keyboard_groups, link) {
-		cg_input_manager_configure_keyboard_group(group);
+		if(changed == NULL ||
+		   input_config_matches(changed, group->identifier, "keyboard")) {
+			cg_input_manager_configure_keyboard_group(group);
+		}
 	}
 }
 
@@ -327,6 +397,7 @@ new_input(struct cg_input_manager *input, struct wlr_input_device *device,
 	input_device->server = input->server;
 	input_device->pointer = NULL;
 	input_device->touch = NULL;
+	input_device->type = input_device_get_type(input_device);
 
 	wl_list_insert(&input->devices, &input_device->link);
 
@@ -348,6 +419,14 @@ handle_new_input(struct wl_listener *listener, void *data) {
 	new_input(input, device, false);
 }
 
+/* Adds a device created by the compositor itself, like the devices used to
+ * replay recorded input */
+void
+input_manager_add_virtual_device(struct cg_input_manager *input,
+                                 struct wlr_input_device *device) {
+	new_input(input, device, true);
+}
+
 void
 handle_virtual_keyboard(struct wl_listener *listener, void *data) {
 
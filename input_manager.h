@@ -1,4 +1,4 @@
-// Copyright 2020 - 2025, project-repo and the cagebreak contributors
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
 // SPDX-License-Identifier: MIT
 
 #ifndef CG_INPUT_MANAGER_H
@@ -20,8 +20,27 @@ input_manager_create_empty_input_config(void);
 struct cg_input_config *
 input_manager_merge_input_configs(struct cg_input_config *cfg1,
                                   struct cg_input_config *cfg2);
+bool
+input_config_matches(const struct cg_input_config *config,
+                     const char *identifier, const char *type);
+struct cg_input_config *
+input_manager_effective_config(struct cg_server *server,
+                               const char *identifier, const char *type);
+struct cg_input_config *
+input_manager_insert_input_config(struct cg_server *server,
+                                  struct cg_input_config *config);
+void
+input_manager_remove_input_configs(struct cg_server *server,
+                                   const char *identifier);
+void
+input_manager_add_input_config(struct cg_server *server,
+                               struct cg_input_config *config);
 void
-cg_input_manager_configure(struct cg_server *server);
+input_manager_add_virtual_device(struct cg_input_manager *input,
+                                 struct wlr_input_device *device);
+void
+cg_input_manager_configure(struct cg_server *server,
+                           const struct cg_input_config *changed);
 void
 cg_input_manager_configure_keyboard_group(struct cg_keyboard_group *group);
 
@@ -56,11 +75,22 @@ enum cg_input_config_mapped_to {
 	MAPPED_TO_REGION,
 };
 
+/* Devices a configuration applies to, in increasing order of precedence */
+enum cg_input_config_match {
+	CG_INPUT_MATCH_ALL,        // "*"
+	CG_INPUT_MATCH_TYPE,       // "type:<type>"
+	CG_INPUT_MATCH_IDENTIFIER, // Exact device identifier
+	CG_INPUT_MATCH_COUNT,
+};
+
 /**
  * options for input devices
  */
 struct cg_input_config {
 	char *identifier;
+	/* Derived from the identifier when the configuration is added */
+	enum cg_input_config_match match;
+	const char *match_type; // Device type following "type:"
 
 	/* Libinput devices */
 	int accel_profile;
@@ -119,6 +149,10 @@ struct cg_input_device {
 	struct wl_list link; // input_manager::devices
 	struct wl_listener device_destroy;
 	bool is_virtual;
+	const char *type; // See input_device_get_type
+	/* All configurations matching the device merged into one, NULL until
+	 * the device is first configured */
+	struct cg_input_config *config;
 
 	/* Only one of the following is non-NULL depending on the type of the input
 	 * device */
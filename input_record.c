@@ -0,0 +1,485 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/interfaces/wlr_keyboard.h>
+#include <wlr/interfaces/wlr_pointer.h>
+#include <wlr/interfaces/wlr_touch.h>
+#include <wlr/util/log.h>
+
+#include "input_manager.h"
+#include "input_record.h"
+#include "ipc_server.h"
+#include "server.h"
+#include "util.h"
+
+struct cg_input_recorder {
+	FILE *file;
+	uint64_t start_ns;
+};
+
+struct cg_input_replay {
+	struct cg_server *server;
+	struct cg_input_event *events;
+	size_t nevents;
+	size_t next; // Index of the next event to replay
+	uint64_t start_ns;
+	struct wl_event_source *timer;
+	/* Stopped replays are only destroyed once idle, as they may be stopped
+	 * while one of their devices emits an event */
+	struct wl_event_source *destroy_idle;
+	struct wl_list link; // cg_server::stopped_replays
+
+	struct wlr_keyboard keyboard;
+	struct wlr_pointer pointer;
+	struct wlr_touch touch;
+
+	uint32_t count[CG_INPUT_EVENT_TYPE_COUNT];
+	uint64_t total_ns[CG_INPUT_EVENT_TYPE_COUNT];
+	uint64_t max_ns[CG_INPUT_EVENT_TYPE_COUNT];
+	uint32_t histogram[CG_INPUT_EVENT_TYPE_COUNT][CG_INPUT_REPLAY_BUCKETS];
+};
+
+static const char *event_type_names[CG_INPUT_EVENT_TYPE_COUNT] = {
+    [CG_INPUT_KEY] = "key",
+    [CG_INPUT_MOTION] = "motion",
+    [CG_INPUT_MOTION_ABSOLUTE] = "motion_absolute",
+    [CG_INPUT_BUTTON] = "button",
+    [CG_INPUT_AXIS] = "axis",
+    [CG_INPUT_FRAME] = "frame",
+    [CG_INPUT_TOUCH_DOWN] = "touch_down",
+    [CG_INPUT_TOUCH_UP] = "touch_up",
+    [CG_INPUT_TOUCH_MOTION] = "touch_motion",
+};
+
+static const struct wlr_keyboard_impl replay_keyboard_impl = {
+    .name = "cagebreak-replay-keyboard",
+};
+
+static const struct wlr_pointer_impl replay_pointer_impl = {
+    .name = "cagebreak-replay-pointer",
+};
+
+static const struct wlr_touch_impl replay_touch_impl = {
+    .name = "cagebreak-replay-touch",
+};
+
+static uint64_t
+now_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return timespec_to_ns(&now);
+}
+
+void
+input_record_start(struct cg_server *server, const char *path) {
+	input_record_stop(server);
+	struct cg_input_recorder *recorder =
+	    calloc(1, sizeof(struct cg_input_recorder));
+	if(recorder == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate input recorder");
+		return;
+	}
+	/* Never overwrite an existing file with a recording */
+	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	recorder->file = fd < 0 ? NULL : fdopen(fd, "wb");
+	if(recorder->file == NULL) {
+		wlr_log(WLR_ERROR, "Unable to create \"%s\" to record input", path);
+		if(fd >= 0) {
+			close(fd);
+		}
+		free(recorder);
+		return;
+	}
+	uint32_t version = CG_INPUT_RECORD_VERSION;
+	if(fwrite(CG_INPUT_RECORD_MAGIC, strlen(CG_INPUT_RECORD_MAGIC), 1,
+	          recorder->file) != 1 ||
+	   fwrite(&version, sizeof(version), 1, recorder->file) != 1) {
+		wlr_log(WLR_ERROR, "Unable to write input record header to \"%s\"",
+		        path);
+		fclose(recorder->file);
+		free(recorder);
+		return;
+	}
+	recorder->start_ns = now_ns();
+	server->input_recorder = recorder;
+	wlr_log(WLR_INFO, "Recording input to \"%s\"", path);
+}
+
+void
+input_record_stop(struct cg_server *server) {
+	struct cg_input_recorder *recorder = server->input_recorder;
+	if(recorder == NULL) {
+		return;
+	}
+	if(fclose(recorder->file) != 0) {
+		wlr_log(WLR_ERROR, "Failed to write input record");
+	}
+	free(recorder);
+	server->input_recorder = NULL;
+}
+
+/* Appends event to the current recording. The caller only fills in the
+ * type specific fields, the timestamp is set here. */
+void
+input_record(struct cg_server *server, struct cg_input_event *event) {
+	struct cg_input_recorder *recorder = server->input_recorder;
+	event->time_ns = now_ns() - recorder->start_ns;
+	if(fwrite(event, sizeof(*event), 1, recorder->file) != 1) {
+		wlr_log(WLR_ERROR, "Failed to write input record, stopping");
+		input_record_stop(server);
+	}
+}
+
+static void
+replay_dispatch(struct cg_input_replay *replay,
+                const struct cg_input_event *event) {
+	uint32_t time_msec = (now_ns() - replay->start_ns) / 1000000;
+	switch(event->type) {
+	case CG_INPUT_KEY: {
+		struct wlr_keyboard_key_event key = {
+		    .time_msec = time_msec,
+		    .keycode = event->code,
+		    .update_state = true,
+		    .state = event->state,
+		};
+		wlr_keyboard_notify_key(&replay->keyboard, &key);
+		break;
+	}
+	case CG_INPUT_MOTION: {
+		struct wlr_pointer_motion_event motion = {
+		    .pointer = &replay->pointer,
+		    .time_msec = time_msec,
+		    .delta_x = event->x,
+		    .delta_y = event->y,
+		    .unaccel_dx = event->x,
+		    .unaccel_dy = event->y,
+		};
+		wl_signal_emit_mutable(&replay->pointer.events.motion, &motion);
+		break;
+	}
+	case CG_INPUT_MOTION_ABSOLUTE: {
+		struct wlr_pointer_motion_absolute_event motion = {
+		    .pointer = &replay->pointer,
+		    .time_msec = time_msec,
+		    .x = event->x,
+		    .y = event->y,
+		};
+		wl_signal_emit_mutable(&replay->pointer.events.motion_absolute,
+		                       &motion);
+		break;
+	}
+	case CG_INPUT_BUTTON: {
+		struct wlr_pointer_button_event button = {
+		    .pointer = &replay->pointer,
+		    .time_msec = time_msec,
+		    .button = event->code,
+		    .state = event->state,
+		};
+		wl_signal_emit_mutable(&replay->pointer.events.button, &button);
+		break;
+	}
+	case CG_INPUT_AXIS: {
+		struct wlr_pointer_axis_event axis = {
+		    .pointer = &replay->pointer,
+		    .time_msec = time_msec,
+		    .source = event->state,
+		    .orientation = event->code,
+		    .relative_direction =
+		        WL_POINTER_AXIS_RELATIVE_DIRECTION_IDENTICAL,
+		    .delta = event->x,
+		    .delta_discrete = event->discrete,
+		};
+		wl_signal_emit_mutable(&replay->pointer.events.axis, &axis);
+		break;
+	}
+	case CG_INPUT_FRAME:
+		wl_signal_emit_mutable(&replay->pointer.events.frame,
+		                       &replay->pointer);
+		break;
+	case CG_INPUT_TOUCH_DOWN: {
+		struct wlr_touch_down_event down = {
+		    .touch = &replay->touch,
+		    .time_msec = time_msec,
+		    .touch_id = event->code,
+		    .x = event->x,
+		    .y = event->y,
+		};
+		wl_signal_emit_mutable(&replay->touch.events.down, &down);
+		break;
+	}
+	case CG_INPUT_TOUCH_UP: {
+		struct wlr_touch_up_event up = {
+		    .touch = &replay->touch,
+		    .time_msec = time_msec,
+		    .touch_id = event->code,
+		};
+		wl_signal_emit_mutable(&replay->touch.events.up, &up);
+		break;
+	}
+	case CG_INPUT_TOUCH_MOTION: {
+		struct wlr_touch_motion_event motion = {
+		    .touch = &replay->touch,
+		    .time_msec = time_msec,
+		    .touch_id = event->code,
+		    .x = event->x,
+		    .y = event->y,
+		};
+		wl_signal_emit_mutable(&replay->touch.events.motion, &motion);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void
+replay_account(struct cg_input_replay *replay, uint32_t type,
+               uint64_t duration_ns) {
+	uint64_t us = duration_ns / 1000;
+	uint32_t bucket = 0;
+	while(bucket < CG_INPUT_REPLAY_BUCKETS - 1 && (1ull << bucket) <= us) {
+		++bucket;
+	}
+	++replay->count[type];
+	replay->total_ns[type] += duration_ns;
+	if(duration_ns > replay->max_ns[type]) {
+		replay->max_ns[type] = duration_ns;
+	}
+	++replay->histogram[type][bucket];
+}
+
+static char *
+replay_print_latency(struct cg_input_replay *replay, uint32_t type) {
+	char *histogram = strdup("");
+	for(uint32_t i = 0; histogram != NULL && i < CG_INPUT_REPLAY_BUCKETS;
+	    ++i) {
+		char *tmp = malloc_vsprintf("%s%s%" PRIu32, histogram,
+		                            i == 0 ? "" : ",",
+		                            replay->histogram[type][i]);
+		free(histogram);
+		histogram = tmp;
+	}
+	if(histogram == NULL) {
+		return NULL;
+	}
+	char *str = malloc_vsprintf(
+	    "\"%s\":{\"count\":%" PRIu32 ",\"avg_us\":%" PRIu64
+	    ",\"max_us\":%" PRIu64 ",\"histogram\":[%s]}",
+	    event_type_names[type], replay->count[type],
+	    replay->total_ns[type] / replay->count[type] / 1000,
+	    replay->max_ns[type] / 1000, histogram);
+	free(histogram);
+	return str;
+}
+
+static void
+replay_send_report(struct cg_input_replay *replay) {
+	char *latency = strdup("");
+	for(uint32_t type = 0; latency != NULL && type < CG_INPUT_EVENT_TYPE_COUNT;
+	    ++type) {
+		if(replay->count[type] == 0) {
+			continue;
+		}
+		char *entry = replay_print_latency(replay, type);
+		char *tmp = NULL;
+		if(entry != NULL) {
+			tmp = malloc_vsprintf("%s%s%s", latency,
+			                      latency[0] == '\0' ? "" : ",", entry);
+		}
+		free(entry);
+		free(latency);
+		latency = tmp;
+	}
+	if(latency == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for replay report");
+		return;
+	}
+	ipc_send_event(replay->server,
+	               "{\"event_name\":\"replay\",\"events\":%zu,"
+	               "\"replayed\":%zu,\"duration_ms\":%" PRIu64
+	               ",\"latency\":{%s}}",
+	               replay->nevents, replay->next,
+	               (now_ns() - replay->start_ns) / 1000000, latency);
+	free(latency);
+}
+
+static int
+handle_replay_timer(void *data) {
+	struct cg_input_replay *replay = data;
+	struct cg_server *server = replay->server;
+	uint64_t elapsed = now_ns() - replay->start_ns;
+	while(replay->next < replay->nevents &&
+	      replay->events[replay->next].time_ns <= elapsed) {
+		const struct cg_input_event *event = &replay->events[replay->next];
+		++replay->next;
+		uint64_t before = now_ns();
+		replay_dispatch(replay, event);
+		uint64_t duration_ns = now_ns() - before;
+		if(server->input_replay != replay) {
+			// The replay was stopped by one of the replayed events
+			return 0;
+		}
+		replay_account(replay, event->type, duration_ns);
+	}
+	if(replay->next == replay->nevents) {
+		input_replay_stop(server);
+		return 0;
+	}
+	uint64_t wait_ns = replay->events[replay->next].time_ns - elapsed;
+	wl_event_source_timer_update(replay->timer,
+	                             wait_ns / 1000000 > 0 ? wait_ns / 1000000 : 1);
+	return 0;
+}
+
+static struct cg_input_event *
+replay_load(const char *path, size_t *nevents) {
+	FILE *file = fopen(path, "rb");
+	if(file == NULL) {
+		wlr_log(WLR_ERROR, "Unable to open input record \"%s\"", path);
+		return NULL;
+	}
+	char magic[sizeof(CG_INPUT_RECORD_MAGIC) - 1];
+	uint32_t version;
+	if(fread(magic, sizeof(magic), 1, file) != 1 ||
+	   memcmp(magic, CG_INPUT_RECORD_MAGIC, sizeof(magic)) != 0 ||
+	   fread(&version, sizeof(version), 1, file) != 1 ||
+	   version != CG_INPUT_RECORD_VERSION) {
+		wlr_log(WLR_ERROR, "\"%s\" is not a valid input record", path);
+		fclose(file);
+		return NULL;
+	}
+
+	size_t cap = 256, n = 0;
+	struct cg_input_event *events = malloc(cap * sizeof(*events));
+	while(events != NULL && fread(&events[n], sizeof(*events), 1, file) == 1) {
+		if(events[n].type >= CG_INPUT_EVENT_TYPE_COUNT) {
+			wlr_log(WLR_ERROR, "Invalid event type %u in input record \"%s\"",
+			        events[n].type, path);
+			free(events);
+			events = NULL;
+			break;
+		}
+		if(++n == cap) {
+			cap *= 2;
+			struct cg_input_event *tmp =
+			    realloc(events, cap * sizeof(*events));
+			if(tmp == NULL) {
+				free(events);
+			}
+			events = tmp;
+		}
+	}
+	if(events == NULL) {
+		wlr_log(WLR_ERROR, "Failed to read input record \"%s\"", path);
+	}
+	fclose(file);
+	*nevents = n;
+	return events;
+}
+
+/* Replays the events recorded in path with their original timing through
+ * a virtual keyboard, pointer and touch device and reports the time spent
+ * handling each event in a replay IPC event */
+void
+input_replay_start(struct cg_server *server, const char *path) {
+	input_replay_stop(server);
+	struct cg_input_replay *replay = calloc(1, sizeof(struct cg_input_replay));
+	if(replay == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate input replay");
+		return;
+	}
+	replay->events = replay_load(path, &replay->nevents);
+	if(replay->events == NULL) {
+		free(replay);
+		return;
+	}
+	replay->timer = wl_event_loop_add_timer(server->event_loop,
+	                                        handle_replay_timer, replay);
+	if(replay->timer == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create timer for input replay");
+		free(replay->events);
+		free(replay);
+		return;
+	}
+	replay->server = server;
+	wl_list_init(&replay->link);
+	server->input_replay = replay;
+
+	wlr_keyboard_init(&replay->keyboard, &replay_keyboard_impl,
+	                  replay_keyboard_impl.name);
+	wlr_pointer_init(&replay->pointer, &replay_pointer_impl,
+	                 replay_pointer_impl.name);
+	wlr_touch_init(&replay->touch, &replay_touch_impl, replay_touch_impl.name);
+	input_manager_add_virtual_device(server->input, &replay->keyboard.base);
+	input_manager_add_virtual_device(server->input, &replay->pointer.base);
+	input_manager_add_virtual_device(server->input, &replay->touch.base);
+
+	wlr_log(WLR_INFO, "Replaying %zu input events from \"%s\"",
+	        replay->nevents, path);
+	replay->start_ns = now_ns();
+	handle_replay_timer(replay);
+}
+
+static void
+replay_destroy(struct cg_input_replay *replay) {
+	if(replay->destroy_idle != NULL) {
+		wl_event_source_remove(replay->destroy_idle);
+	}
+	wl_list_remove(&replay->link);
+	wlr_keyboard_finish(&replay->keyboard);
+	wlr_pointer_finish(&replay->pointer);
+	wlr_touch_finish(&replay->touch);
+	free(replay->events);
+	free(replay);
+}
+
+static int
+handle_replay_destroy(void *data) {
+	struct cg_input_replay *replay = data;
+	replay->destroy_idle = NULL;
+	replay_destroy(replay);
+	return 0;
+}
+
+/* Stops the current replay and reports its results. It is destroyed once
+ * the event loop is idle. */
+void
+input_replay_stop(struct cg_server *server) {
+	struct cg_input_replay *replay = server->input_replay;
+	if(replay == NULL) {
+		return;
+	}
+	server->input_replay = NULL;
+	replay_send_report(replay);
+	wl_event_source_remove(replay->timer);
+	replay->timer = NULL;
+	wl_list_insert(&server->stopped_replays, &replay->link);
+	replay->destroy_idle = wl_event_loop_add_idle(
+	    server->event_loop, handle_replay_destroy, replay);
+	if(replay->destroy_idle == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create idle source for input replay, "
+		                   "destroying it on exit");
+	}
+}
+
+/* Stops the current replay and destroys all stopped ones right away. This
+ * must not be called while a replayed event is handled. */
+void
+input_replay_finish(struct cg_server *server) {
+	input_replay_stop(server);
+	struct cg_input_replay *replay, *tmp;
+	wl_list_for_each_safe(replay, tmp, &server->stopped_replays, link) {
+		replay_destroy(replay);
+	}
+}
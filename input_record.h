@@ -0,0 +1,54 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_INPUT_RECORD_H
+#define CG_INPUT_RECORD_H
+
+#include <stdint.h>
+
+struct cg_server;
+
+#define CG_INPUT_RECORD_MAGIC "CGINPREC"
+#define CG_INPUT_RECORD_VERSION 1
+// Latency histogram buckets, bucket i counts events taking < 2^i us
+#define CG_INPUT_REPLAY_BUCKETS 16
+
+enum cg_input_event_type {
+	CG_INPUT_KEY,
+	CG_INPUT_MOTION,
+	CG_INPUT_MOTION_ABSOLUTE,
+	CG_INPUT_BUTTON,
+	CG_INPUT_AXIS,
+	CG_INPUT_FRAME,
+	CG_INPUT_TOUCH_DOWN,
+	CG_INPUT_TOUCH_UP,
+	CG_INPUT_TOUCH_MOTION,
+	CG_INPUT_EVENT_TYPE_COUNT,
+};
+
+/* A recorded input event as stored in the record file, following the magic
+ * string and the version */
+struct cg_input_event {
+	uint64_t time_ns; // Time since the start of the recording
+	uint32_t type;    // enum cg_input_event_type
+	uint32_t code;    // Keycode, button, axis orientation or touch id
+	uint32_t state;   // Key or button state, axis source
+	int32_t discrete; // Discrete axis delta
+	double x;         // Motion delta, absolute position or axis delta
+	double y;
+};
+
+void
+input_record_start(struct cg_server *server, const char *path);
+void
+input_record_stop(struct cg_server *server);
+void
+input_record(struct cg_server *server, struct cg_input_event *event);
+void
+input_replay_start(struct cg_server *server, const char *path);
+void
+input_replay_stop(struct cg_server *server);
+void
+input_replay_finish(struct cg_server *server);
+
+#endif
@@ -3,9 +3,10 @@
 
 #define _POSIX_C_SOURCE 200809L
 
+#include <inttypes.h>
 #include <signal.h>
+#include <stdio.h>
 #include <string.h>
-#include <sys/wait.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/backend/multi.h>
@@ -17,13 +18,18 @@
 #include <wlr/types/wlr_xcursor_manager.h>
 #include <wlr/util/log.h>
 
+#include "chord.h"
+#include "frame_stats.h"
 #include "input.h"
 #include "input_manager.h"
+#include "input_record.h"
 #include "keybinding.h"
 #include "message.h"
 #include "output.h"
+#include "reload.h"
 #include "seat.h"
 #include "server.h"
+#include "spawn.h"
 #include "util.h"
 #include "view.h"
 #include "workspace.h"
@@ -98,11 +104,26 @@ keybinding_free(struct keybinding *keybinding, bool recursive) {
 			free(keybinding->data.c);
 		}
 		break;
+	case KEYBINDING_OVERLAY:
+		free(keybinding->data.ov_cfg->name);
+		free(keybinding->data.ov_cfg->text);
+		free(keybinding->data.ov_cfg);
+		break;
 	case KEYBINDING_SEND_CUSTOM_EVENT:
 		if(keybinding->data.c != NULL) {
 			free(keybinding->data.c);
 		}
 		break;
+	case KEYBINDING_RECORD:
+	case KEYBINDING_REPLAY:
+		free(keybinding->data.c);
+		break;
+	case KEYBINDING_DEFINECHORD:
+		if(keybinding->data.ch->kb != NULL && recursive) {
+			keybinding_free(keybinding->data.ch->kb, true);
+		}
+		free(keybinding->data.ch);
+		break;
 	case KEYBINDING_SETMODECURSOR:
 		if(keybinding->data.cs[0] != NULL) {
 			free(keybinding->data.cs[0]);
@@ -139,6 +160,23 @@ keybinding_list_push(struct keybinding_list *list,
 	return 0;
 }
 
+/* Removes the keybinding for the key, modifiers and mode of keybinding from
+ * list, returns -1 if there is none */
+int
+keybinding_list_remove(struct keybinding_list *list,
+                       const struct keybinding *keybinding) {
+	struct keybinding **found_keybinding = find_keybinding(list, keybinding);
+	if(found_keybinding == NULL) {
+		return -1;
+	}
+	keybinding_free(*found_keybinding, true);
+	size_t idx = found_keybinding - list->keybindings;
+	memmove(found_keybinding, found_keybinding + 1,
+	        (list->length - idx - 1) * sizeof(struct keybinding *));
+	--list->length;
+	return 0;
+}
+
 struct keybinding_list *
 keybinding_list_init(void) {
 	struct keybinding_list *list = malloc(sizeof(struct keybinding_list));
@@ -343,6 +381,8 @@ merge_tile(struct cg_tile *tile,
 		tile->workspace->server->seat->cursor_tile = tile;
 	}
 	free(merge_tile);
+	++tile->workspace->server->scene_generation;
+	++tile->workspace->server->layout_generation;
 	if(tile->view != NULL) {
 		view_maximize(tile->view, tile);
 	}
@@ -368,6 +408,7 @@ swap_tiles(struct cg_tile *tile, struct cg_tile *swap_tile, bool follow) {
 	workspace_tile_update_view(tile, NULL);
 	workspace_tile_update_view(swap_tile, tmp_view);
 	workspace_tile_update_view(tile, tmp_swap_view);
+	++server->layout_generation;
 	if(follow) {
 		keybinding_focus_tile(server, swap_tile->id);
 	} else {
@@ -570,6 +611,8 @@ resize(struct cg_tile *tile, const struct cg_tile *parent, int coord_offset,
 	    old_height = tile->tile.height, old_width = tile->tile.width;
 	*get_coord(tile) += coord_offset;
 	*get_dim(tile) += dim_offset;
+	++tile->workspace->server->scene_generation;
+	++tile->workspace->server->layout_generation;
 
 	if(tile->view != NULL) {
 		view_maximize(tile->view, tile);
@@ -748,13 +791,14 @@ keybinding_split_output(struct cg_output *output, bool vertical,
 	new_tile->tile.height = y + height - new_y;
 	new_tile->prev = curr_workspace->focused_tile;
 	new_tile->next = curr_workspace->focused_tile->next;
-	workspace_tile_update_view(new_tile, next_view);
 	new_tile->workspace = curr_workspace;
+	workspace_tile_update_view(new_tile, next_view);
 	curr_workspace->focused_tile->next->prev = new_tile;
 	curr_workspace->focused_tile->next = new_tile;
 
 	curr_workspace->focused_tile->tile.width = new_width;
 	curr_workspace->focused_tile->tile.height = new_height;
+	++output->server->layout_generation;
 	workspace_focus_tile(curr_workspace, curr_workspace->focused_tile);
 
 	if(next_view != NULL) {
@@ -801,12 +845,6 @@ keybinding_split_horizontal(struct cg_server *server, float percentage) {
 	keybinding_split_output(server->curr_output, false, percentage);
 }
 
-static void
-into_process(const char *command) {
-	execlp("sh", "sh", "-c", command, (char *)NULL);
-	_exit(1);
-}
-
 void
 set_output(struct cg_server *server, struct cg_output *output) {
 	server->curr_output = output;
@@ -814,7 +852,7 @@ set_output(struct cg_server *server, struct cg_output *output) {
 	    server->seat,
 	    server->curr_output->workspaces[server->curr_output->curr_workspace]
 	        ->focused_tile->view);
-	message_printf(server->curr_output, "Current Output");
+	message_indicator(server->curr_output, CG_INDICATOR_OUTPUT, NULL);
 }
 
 void
@@ -1032,7 +1070,7 @@ print_message_conf(struct cg_message_config *config) {
 	struct dyn_str outp_str;
 	outp_str.len = 0;
 	outp_str.cur_pos = 0;
-	uint32_t nmemb = 8;
+	uint32_t nmemb = 9;
 	outp_str.str_arr = calloc(nmemb, sizeof(char *));
 	print_str(&outp_str, "\"message_config\": {");
 	print_str(&outp_str, "\"font\": \"%s\",\n", config->font);
@@ -1042,6 +1080,8 @@ print_message_conf(struct cg_message_config *config) {
 	print_str(&outp_str, "\"fg_color\": [%f,%f,%f,%f],\n", config->fg_color[0],
 	          config->fg_color[1], config->fg_color[2], config->fg_color[3]);
 	print_str(&outp_str, "\"enabled\": %d,\n", config->enabled == 1);
+	print_str(&outp_str, "\"focus_indicator\": %d,\n",
+	          config->focus_indicator == 1);
 	switch(config->anchor) {
 	case CG_MESSAGE_TOP_LEFT:
 		print_str(&outp_str, "\"anchor\": \"top_left\"\n", config->font);
@@ -1110,7 +1150,7 @@ print_view(struct cg_view *view) {
 	struct dyn_str outp_str;
 	outp_str.len = 0;
 	outp_str.cur_pos = 0;
-	uint32_t nmemb = 5;
+	uint32_t nmemb = 6;
 	outp_str.str_arr = calloc(nmemb, sizeof(char *));
 	print_str(&outp_str, "\"id\": %d,\n", view->id);
 	print_str(&outp_str, "\"pid\": %d,\n", view->impl->get_pid(view));
@@ -1121,6 +1161,13 @@ print_view(struct cg_view *view) {
 	}
 	print_str(&outp_str, "\"coords\": {\"x\":%d,\"y\":%d},\n", view->ox,
 	          view->oy);
+	const struct cg_view_latency *latency = &view->latency;
+	print_str(&outp_str,
+	          "\"latency_us\": {\"frames\":%" PRIu32 ",\"last\":%" PRIu64
+	          ",\"avg\":%" PRIu64 ",\"max\":%" PRIu64 "},\n",
+	          latency->count, latency->last_ns / 1000,
+	          latency->count == 0 ? 0 : latency->sum_ns / latency->count / 1000,
+	          latency->max_ns / 1000);
 #if CG_HAS_XWAYLAND
 	print_str(&outp_str, "\"type\": \"%s\"\n",
 	          view->type == CG_XWAYLAND_VIEW ? "xwayland" : "xdg");
@@ -1421,11 +1468,17 @@ keybinding_dump(struct cg_server *server) {
 	struct dyn_str str;
 	str.len = 0;
 	str.cur_pos = 0;
-	uint32_t nmemb = 14;
+	uint32_t nmemb = 16;
 	str.str_arr = calloc(nmemb, sizeof(char *));
 
 	print_str(&str, "{\"event_name\":\"dump\",");
 	print_str(&str, "\"nws\":%d,\n", server->nws);
+	print_str(&str, "\"idle_interval\":%u,\n", server->idle_interval);
+	print_str(&str,
+	          "\"chords\":{\"states\":%u,\"transitions\":%u,"
+	          "\"timeout\":%u},\n",
+	          server->chords->nstates, server->chords->nedges,
+	          server->chords->timeout);
 	print_str(&str, "\"bg_color\":[%f,%f,%f],\n", server->bg_color[0],
 	          server->bg_color[1], server->bg_color[2]);
 	struct cg_view *focused_view = seat_get_focus(server->seat);
@@ -1474,6 +1527,31 @@ keybinding_dump(struct cg_server *server) {
 	free(send_str);
 }
 
+void
+keybinding_stats(struct cg_server *server, enum cg_stats_kind kind,
+                 uint32_t num) {
+	switch(kind) {
+	case CG_STATS_STREAM:
+		frame_stats_set_stream(server, num);
+		return;
+	case CG_STATS_INPUT:
+		seat_send_input_stats(server->seat);
+		return;
+	case CG_STATS_LAUNCH:
+		spawn_send_launch_stats(server);
+		return;
+	case CG_STATS_OUTPUT:
+		break;
+	}
+	struct cg_output *output = output_from_num(server, num);
+	if(output == NULL || output->destroyed) {
+		wlr_log(WLR_ERROR, "Output %u does not exist, cannot send statistics",
+		        num);
+		return;
+	}
+	frame_stats_send(output);
+}
+
 void
 keybinding_show_info(struct cg_server *server) {
 	char *msg = server_show_info(server);
@@ -1491,6 +1569,25 @@ keybinding_display_message(struct cg_server *server, char *msg) {
 	message_printf(server->curr_output, "%s", msg);
 }
 
+void
+keybinding_overlay(struct cg_server *server, struct cg_overlay_config *cfg) {
+	switch(cfg->action) {
+	case CG_OVERLAY_SET:
+		overlay_set(server->curr_output, cfg->name, cfg->anchor, cfg->text,
+		            NULL);
+		break;
+	case CG_OVERLAY_CLOCK:
+		overlay_set(server->curr_output, cfg->name, cfg->anchor, NULL,
+		            cfg->text);
+		break;
+	case CG_OVERLAY_REMOVE:
+		if(overlay_remove(server->curr_output, cfg->name) != 0) {
+			wlr_log(WLR_ERROR, "Overlay \"%s\" does not exist", cfg->name);
+		}
+		break;
+	}
+}
+
 void
 keybinding_send_custom_event(struct cg_server *server, char *msg) {
 	ipc_send_event(server,
@@ -1550,6 +1647,7 @@ keybinding_set_nws(struct cg_server *server, int nws) {
 	struct cg_output *output;
 	unsigned int old_nws = server->nws;
 	server->nws = nws;
+	++server->layout_generation;
 	wl_list_for_each(output, &server->outputs, link) {
 		for(unsigned int i = nws; i < old_nws; ++i) {
 			struct cg_view *view, *tmp;
@@ -1639,6 +1737,29 @@ keybinding_definekey(struct cg_server *server, struct keybinding *kb) {
 	               keybinding_action_string[kb->action]);
 }
 
+void
+keybinding_definechord(struct cg_server *server, struct cg_chord_config *ch) {
+	if(ch->kb == NULL) {
+		return;
+	}
+	if(chord_add(server->chords, ch) != 0) {
+		keybinding_free(ch->kb, true);
+		ch->kb = NULL;
+		return;
+	}
+	char keys[CG_CHORD_MAX_KEYS * 48] = "";
+	size_t len = 0;
+	for(uint32_t i = 0; i < ch->nkeys && len < sizeof(keys); ++i) {
+		len += snprintf(keys + len, sizeof(keys) - len,
+		                "%s{\"modifiers\":%d,\"key\":%d}", i > 0 ? "," : "",
+		                ch->keys[i].modifiers, ch->keys[i].key);
+	}
+	ipc_send_event(server,
+	               "{\"event_name\":\"definechord\",\"keys\":[%s],"
+	               "\"command\":\"%s\"}",
+	               keys, keybinding_action_string[ch->kb->action]);
+}
+
 void
 keybinding_set_background(struct cg_server *server, float *bg) {
 	ipc_send_event(server,
@@ -1767,90 +1888,77 @@ keybinding_move_view_to_workspace(struct cg_server *server, int view_id,
 	    follow);
 }
 
-void
-merge_config(struct cg_output_config *config_new,
-             struct cg_output_config *config_old) {
-	if(config_new->status == OUTPUT_DEFAULT) {
-		config_new->status = config_old->status;
-	}
-	if(config_new->pos.x == -1) {
-		config_new->pos = config_old->pos;
-	}
-	if(config_new->refresh_rate == 0) {
-		config_new->refresh_rate = config_old->refresh_rate;
-	}
-	if(config_new->priority == -1) {
-		config_new->priority = config_old->priority;
+/* Merges cfg into the stored configuration of its output without applying
+ * it to the output */
+int
+keybinding_add_output_config(struct cg_server *server,
+                             struct cg_output_config *cfg) {
+	struct cg_output_config *config =
+	    output_config_find(server, cfg->output_name);
+	if(config != NULL) {
+		output_config_merge(config, cfg);
+		return 0;
 	}
-}
 
-void
-keybinding_configure_output(struct cg_server *server,
-                            struct cg_output_config *cfg) {
-	struct cg_output_config *config;
 	config = malloc(sizeof(struct cg_output_config));
 	if(config == NULL) {
 		wlr_log(WLR_ERROR,
 		        "Could not allocate memory for server configuration.");
-		return;
+		return -1;
 	}
-
 	*config = *cfg;
 	config->output_name = strdup(cfg->output_name);
-
-	struct cg_output_config *it, *tmp;
-	wl_list_for_each_safe(it, tmp, &server->output_config, link) {
-		if(strcmp(config->output_name, it->output_name) == 0) {
-			wl_list_remove(&it->link);
-			merge_config(config, it);
-			free(it->output_name);
-			free(it);
-		}
+	if(config->output_name == NULL) {
+		wlr_log(WLR_ERROR,
+		        "Could not allocate memory for server configuration.");
+		free(config);
+		return -1;
 	}
 	wl_list_insert(&server->output_config, &config->link);
+	return 0;
+}
 
+/* Applies the stored configuration to the output with the given name, if
+ * there is one */
+void
+keybinding_apply_output_config(struct cg_server *server, const char *name) {
 	struct cg_output *output, *tmp_output;
 	wl_list_for_each_safe(output, tmp_output, &server->outputs, link) {
-		if(strcmp(config->output_name, output->name) == 0) {
+		if(strcmp(name, output->name) == 0) {
 			int output_num = output_get_num(output);
 			output_configure(server, output);
 			ipc_send_event(server,
 			               "{\"event_name\":\"configure_output\",\"output\":\"%"
 			               "s\",\"output_id\":%d}",
-			               cfg->output_name, output_num);
+			               name, output_num);
 			return;
 		}
 	}
 	wl_list_for_each_safe(output, tmp_output, &server->disabled_outputs, link) {
-		if(strcmp(config->output_name, output->name) == 0) {
+		if(strcmp(name, output->name) == 0) {
 			output_configure(server, output);
 			ipc_send_event(
 			    output->server,
 			    "{\"event_name\":\"configure_output\",\"output\":\"%s\"}",
-			    cfg->output_name);
+			    name);
 			return;
 		}
 	}
 }
 
 void
-keybinding_configure_input(struct cg_server *server,
-                           struct cg_input_config *cfg) {
-	struct cg_input_config *tcfg = input_manager_create_empty_input_config();
-	if(tcfg == NULL) {
-		wlr_log(WLR_ERROR,
-		        "Could not allocate temporary empty input configuration.");
-		return;
-	}
-	struct cg_input_config *ocfg = input_manager_merge_input_configs(cfg, tcfg);
-	free(tcfg);
-	if(ocfg == NULL) {
-		wlr_log(WLR_ERROR,
-		        "Could not allocate input configuration for merging.");
+keybinding_configure_output(struct cg_server *server,
+                            struct cg_output_config *cfg) {
+	if(keybinding_add_output_config(server, cfg) != 0) {
 		return;
 	}
-	wl_list_insert(&server->input_config, &ocfg->link);
-	cg_input_manager_configure(server);
+	keybinding_apply_output_config(server, cfg->output_name);
+}
+
+void
+keybinding_configure_input(struct cg_server *server,
+                           struct cg_input_config *cfg) {
+	input_manager_add_input_config(server, cfg);
 	ipc_send_event(server,
 	               "{\"event_name\":\"configure_input\",\"input\":\"%s\"}",
 	               cfg->identifier);
@@ -1884,6 +1992,22 @@ keybinding_configure_message(struct cg_server *server,
 	if(config->enabled != -1) {
 		server->message_config.enabled = config->enabled;
 	}
+	if(config->focus_indicator != -1) {
+		server->message_config.focus_indicator = config->focus_indicator;
+	}
+	/* The cached focus indicators and the overlays depend on font and
+	 * colours */
+	bool style_changed = config->font != NULL || config->bg_color[0] != -1 ||
+	                     config->fg_color[0] != -1;
+	if(style_changed || config->focus_indicator == 0) {
+		struct cg_output *output;
+		wl_list_for_each(output, &server->outputs, link) {
+			message_indicator_clear(output);
+			if(style_changed) {
+				overlay_update(output, true);
+			}
+		}
+	}
 	ipc_send_event(server, "{\"event_name\":\"configure_message\"}");
 }
 
@@ -1892,13 +2016,12 @@ set_cursor(bool enabled, struct cg_seat *seat) {
 	if(enabled == true) {
 		seat->enable_cursor = true;
 		if(seat->server->renderer) {
-			wlr_cursor_set_xcursor(seat->cursor, seat->xcursor_manager,
-			                       DEFAULT_XCURSOR);
+			seat_set_xcursor(seat, DEFAULT_XCURSOR);
 		}
 	} else {
 		seat->enable_cursor = false;
 		if(seat->server->renderer) {
-			wlr_cursor_unset_image(seat->cursor);
+			seat_unset_cursor_image(seat);
 		}
 	}
 }
@@ -1926,21 +2049,9 @@ run_action(enum keybinding_action action, struct cg_server *server,
 	case KEYBINDING_SPLIT_VERTICAL:
 		keybinding_split_vertical(server, data.f);
 		break;
-	case KEYBINDING_RUN_COMMAND: {
-		int pid;
-		if((pid = fork()) == 0) {
-			setsid();
-			sigset_t set;
-			sigemptyset(&set);
-			sigprocmask(SIG_SETMASK, &set, NULL);
-			if(fork() == 0) {
-				into_process(data.c);
-			}
-			_exit(0);
-		} else if(pid > 0) {
-			waitpid(pid, NULL, 0);
-		}
-	} break;
+	case KEYBINDING_RUN_COMMAND:
+		spawn_command(server, data.c);
+		break;
 	case KEYBINDING_CYCLE_VIEWS:
 		keybinding_cycle_views(server, NULL, data.us[1], data.us[0], true);
 		break;
@@ -1970,9 +2081,7 @@ run_action(enum keybinding_action action, struct cg_server *server,
 			wlr_seat_pointer_notify_clear_focus(server->seat->seat);
 			if(server->seat->enable_cursor == true &&
 			   server->modecursors[data.u] != NULL && server->renderer) {
-				wlr_cursor_set_xcursor(server->seat->cursor,
-				                       server->seat->xcursor_manager,
-				                       server->modecursors[data.u]);
+				seat_set_xcursor(server->seat, server->modecursors[data.u]);
 			}
 		}
 		server->seat->mode = data.u;
@@ -1992,13 +2101,9 @@ run_action(enum keybinding_action action, struct cg_server *server,
 			if(server->seat->enable_cursor == true &&
 			   server->seat->num_pointers > 0 && server->renderer) {
 				if(server->modecursors[data.u] != NULL) {
-					wlr_cursor_set_xcursor(server->seat->cursor,
-					                       server->seat->xcursor_manager,
-					                       server->modecursors[data.u]);
+					seat_set_xcursor(server->seat, server->modecursors[data.u]);
 				} else {
-					wlr_cursor_set_xcursor(server->seat->cursor,
-					                       server->seat->xcursor_manager,
-					                       DEFAULT_XCURSOR);
+					seat_set_xcursor(server->seat, DEFAULT_XCURSOR);
 				}
 			}
 		}
@@ -2013,12 +2118,18 @@ run_action(enum keybinding_action action, struct cg_server *server,
 	case KEYBINDING_DUMP:
 		keybinding_dump(server);
 		break;
+	case KEYBINDING_STATS:
+		keybinding_stats(server, data.us[0], data.us[1]);
+		break;
 	case KEYBINDING_SHOW_INFO:
 		keybinding_show_info(server);
 		break;
 	case KEYBINDING_DISPLAY_MESSAGE:
 		keybinding_display_message(server, data.c);
 		break;
+	case KEYBINDING_OVERLAY:
+		keybinding_overlay(server, data.ov_cfg);
+		break;
 	case KEYBINDING_SEND_CUSTOM_EVENT:
 		keybinding_send_custom_event(server, data.c);
 		break;
@@ -2176,6 +2287,28 @@ run_action(enum keybinding_action action, struct cg_server *server,
 	case KEYBINDING_WORKSPACES:
 		keybinding_set_nws(server, data.i);
 		break;
+	case KEYBINDING_IDLE_INTERVAL:
+		server->idle_interval = data.u;
+		break;
+	case KEYBINDING_RECORD:
+		if(data.c != NULL) {
+			input_record_start(server, data.c);
+		} else {
+			input_record_stop(server);
+		}
+		break;
+	case KEYBINDING_REPLAY:
+		input_replay_start(server, data.c);
+		break;
+	case KEYBINDING_DEFINECHORD:
+		keybinding_definechord(server, data.ch);
+		break;
+	case KEYBINDING_CHORD_TIMEOUT:
+		server->chords->timeout = data.u;
+		break;
+	case KEYBINDING_RELOAD:
+		config_reload(server);
+		break;
 	case KEYBINDING_CONFIGURE_OUTPUT:
 		keybinding_configure_output(server, data.o_cfg);
 		break;
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <xkbcommon/xkbcommon.h>
 
+struct cg_chord_config;
 struct cg_server;
 
 #define FOREACH_KEYBINDING(KEYBINDING)                                         \
@@ -77,9 +78,15 @@ struct cg_server;
 	           move_view_to_cycle_output) /* data.b is 0 if forward, 1 if */   \
                                                                                \
 	KEYBINDING(KEYBINDING_DUMP, dump)                                          \
+	KEYBINDING(KEYBINDING_STATS,                                               \
+	           stats) /* data.us[0] is the enum cg_stats_kind and data.us[1]   \
+	                     is the output for CG_STATS_OUTPUT or the interval for \
+	                     CG_STATS_STREAM */                                    \
 	KEYBINDING(KEYBINDING_SHOW_TIME, time)                                     \
 	KEYBINDING(KEYBINDING_SHOW_INFO, show_info)                                \
 	KEYBINDING(KEYBINDING_DISPLAY_MESSAGE, message)                            \
+	KEYBINDING(KEYBINDING_OVERLAY,                                             \
+	           overlay) /* data.ov_cfg is the overlay command */               \
 	KEYBINDING(KEYBINDING_SEND_CUSTOM_EVENT, custom_event)                     \
 	KEYBINDING(KEYBINDING_CURSOR, cursor)                                      \
                                                                                \
@@ -112,7 +119,18 @@ struct cg_server;
 	KEYBINDING(KEYBINDING_DEFINEMODE,                                          \
 	           definemode) /* data.c is the mode name */                       \
 	KEYBINDING(KEYBINDING_WORKSPACES,                                          \
-	           workspaces) /* data.i is the number of workspaces */
+	           workspaces) /* data.i is the number of workspaces */            \
+	KEYBINDING(KEYBINDING_IDLE_INTERVAL,                                       \
+	           idle_interval) /* data.u is the interval in milliseconds */     \
+	KEYBINDING(KEYBINDING_RECORD,                                              \
+	           record) /* data.c is the file to record to, NULL to stop */     \
+	KEYBINDING(KEYBINDING_REPLAY,                                              \
+	           replay) /* data.c is the file to replay */                      \
+	KEYBINDING(KEYBINDING_DEFINECHORD,                                         \
+	           definechord) /* data.ch is the chord definition */              \
+	KEYBINDING(KEYBINDING_CHORD_TIMEOUT,                                       \
+	           chord_timeout) /* data.u is the timeout in milliseconds */      \
+	KEYBINDING(KEYBINDING_RELOAD, reload)
 
 #define GENERATE_ENUM(ENUM, NAME) ENUM,
 #define GENERATE_STRING(STRING, NAME) #NAME,
@@ -122,6 +140,14 @@ struct cg_server;
  * in keybinding.c */
 enum keybinding_action { FOREACH_KEYBINDING(GENERATE_ENUM) };
 
+/* Subcommands of "stats" */
+enum cg_stats_kind {
+	CG_STATS_OUTPUT,
+	CG_STATS_STREAM,
+	CG_STATS_INPUT,
+	CG_STATS_LAUNCH,
+};
+
 extern char *keybinding_action_string[];
 
 union keybinding_params {
@@ -138,6 +164,8 @@ union keybinding_params {
 	struct cg_output_config *o_cfg;
 	struct cg_input_config *i_cfg;
 	struct cg_message_config *m_cfg;
+	struct cg_overlay_config *ov_cfg;
+	struct cg_chord_config *ch;
 };
 
 struct keybinding {
@@ -157,6 +185,9 @@ struct keybinding_list {
 int
 keybinding_list_push(struct keybinding_list *list,
                      struct keybinding *keybinding);
+int
+keybinding_list_remove(struct keybinding_list *list,
+                       const struct keybinding *keybinding);
 void
 keybinding_list_free(struct keybinding_list *list);
 void
@@ -173,5 +204,10 @@ run_action(enum keybinding_action action, struct cg_server *server,
            union keybinding_params data);
 void
 keybinding_free(struct keybinding *keybinding, bool recursive);
+int
+keybinding_add_output_config(struct cg_server *server,
+                             struct cg_output_config *cfg);
+void
+keybinding_apply_output_config(struct cg_server *server, const char *name);
 
 #endif /* end of include guard KEYBINDINGS_H */
@@ -0,0 +1,374 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+
+#include "launcher.h"
+#include "server.h"
+#include "spawn.h"
+
+extern char **environ;
+
+static size_t
+env_name_len(const char *entry) {
+	return strcspn(entry, "=");
+}
+
+static bool
+env_same_name(const char *a, const char *b) {
+	size_t len = env_name_len(a);
+	return len == env_name_len(b) && strncmp(a, b, len) == 0;
+}
+
+/* Returns the entry of env which sets the variable named by entry */
+static char *
+env_find(char *const *env, const char *entry) {
+	for(; *env != NULL; ++env) {
+		if(env_same_name(*env, entry)) {
+			return *env;
+		}
+	}
+	return NULL;
+}
+
+/* The launcher process, which only ever leaves through _exit */
+
+static int sigchld_pipe[2];
+
+static void
+handle_launcher_sigchld(__attribute__((unused)) int signal) {
+	int saved_errno = errno;
+	ssize_t ret = write(sigchld_pipe[1], "", 1);
+	(void)ret;
+	errno = saved_errno;
+}
+
+static void
+launcher_reply(int fd, enum cg_launcher_reply_type type, pid_t pid, int err) {
+	struct cg_launcher_reply reply = {.type = type, .pid = pid, .err = err};
+	if(send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply)) {
+		_exit(1);
+	}
+}
+
+/* A request is the command followed by the changes to the environment of
+ * the launcher, "NAME=value" to set a variable and "NAME" to unset it. All
+ * strings are NUL-terminated. */
+static void
+launcher_handle_request(int fd, char *request, size_t len) {
+	char *end = request + len;
+	char *command = request;
+	char *changes = command + strlen(command) + 1;
+
+	size_t n = 0;
+	for(char **it = environ; *it != NULL; ++it) {
+		++n;
+	}
+	for(char *it = changes; it < end; it += strlen(it) + 1) {
+		++n;
+	}
+	char **envp = malloc((n + 1) * sizeof(char *));
+	if(envp == NULL) {
+		launcher_reply(fd, CG_LAUNCHER_SPAWNED, -1, ENOMEM);
+		return;
+	}
+	n = 0;
+	for(char *it = changes; it < end; it += strlen(it) + 1) {
+		if(strchr(it, '=') != NULL) {
+			envp[n++] = it;
+		}
+	}
+	for(char **it = environ; *it != NULL; ++it) {
+		bool changed = false;
+		for(char *change = changes; change < end && !changed;
+		    change += strlen(change) + 1) {
+			changed = env_same_name(*it, change);
+		}
+		if(!changed) {
+			envp[n++] = *it;
+		}
+	}
+	envp[n] = NULL;
+
+	pid_t pid = -1;
+	int err = spawn_process(&pid, command, envp);
+	free(envp);
+	launcher_reply(fd, CG_LAUNCHER_SPAWNED, err == 0 ? pid : -1, err);
+}
+
+static void
+launcher_run(int fd, bool (*drop_permissions)(void)) {
+	if(!drop_permissions()) {
+		_exit(1);
+	}
+	/* Keep nothing but the standard streams and the socket, and start the
+	 * commands with the default signal mask */
+	if(fd > STDERR_FILENO + 1) {
+		close_range(STDERR_FILENO + 1, fd - 1, 0);
+	}
+	close_range(fd + 1, ~0U, 0);
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigprocmask(SIG_SETMASK, &mask, NULL);
+
+	if(pipe2(sigchld_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+		_exit(1);
+	}
+	struct sigaction act = {.sa_handler = handle_launcher_sigchld,
+	                        .sa_flags = SA_RESTART | SA_NOCLDSTOP};
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGCHLD, &act, NULL);
+
+	char *request = malloc(CG_LAUNCHER_REQUEST_MAX + 1);
+	if(request == NULL) {
+		_exit(1);
+	}
+	struct pollfd fds[2] = {{.fd = fd, .events = POLLIN},
+	                        {.fd = sigchld_pipe[0], .events = POLLIN}};
+	while(true) {
+		if(poll(fds, 2, -1) < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			_exit(1);
+		}
+		if(fds[1].revents & POLLIN) {
+			char buf[64];
+			ssize_t ret = read(sigchld_pipe[0], buf, sizeof(buf));
+			(void)ret;
+			pid_t pid;
+			while((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+				launcher_reply(fd, CG_LAUNCHER_EXITED, pid, 0);
+			}
+		}
+		if(fds[0].revents != 0) {
+			ssize_t len = recv(fd, request, CG_LAUNCHER_REQUEST_MAX, 0);
+			if(len < 0 && errno == EINTR) {
+				continue;
+			}
+			if(len <= 0) {
+				// The compositor is gone
+				_exit(0);
+			}
+			request[len] = '\0';
+			launcher_handle_request(fd, request, len);
+		}
+	}
+}
+
+/* The compositor side */
+
+static struct cg_child *
+find_child(struct cg_server *server, pid_t pid) {
+	struct cg_child *child;
+	wl_list_for_each(child, &server->children, link) {
+		if(child->launched && !child->exited && child->pid == pid) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
+static void
+handle_reply(struct cg_server *server, const struct cg_launcher_reply *reply) {
+	if(reply->type == CG_LAUNCHER_EXITED) {
+		struct cg_child *child = find_child(server, reply->pid);
+		if(child != NULL) {
+			spawn_child_exited(child);
+		}
+		return;
+	}
+	/* Replies come in the order of the requests */
+	struct cg_child *child = find_child(server, 0);
+	if(child == NULL) {
+		return;
+	}
+	if(reply->pid < 0) {
+		wlr_log(WLR_ERROR, "Launcher failed to run \"%s\": %s",
+		        child->command, strerror(reply->err));
+		spawn_child_destroy(child);
+		return;
+	}
+	child->pid = reply->pid;
+}
+
+static int
+handle_launcher_readable(int fd, uint32_t mask, void *data) {
+	struct cg_server *server = data;
+	struct cg_launcher_reply reply;
+	ssize_t len;
+	while((len = recv(fd, &reply, sizeof(reply), MSG_DONTWAIT)) ==
+	      sizeof(reply)) {
+		handle_reply(server, &reply);
+	}
+	if(len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR) ||
+	   (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR))) {
+		wlr_log(WLR_ERROR, "Launcher exited, running commands directly");
+		launcher_finish(server);
+	}
+	return 0;
+}
+
+/* Forks the launcher. This should happen before the compositor opens any
+ * devices or grows, such that the launcher shares as little with it as
+ * possible. The launcher calls drop_permissions before anything else. */
+int
+launcher_start(struct cg_server *server, bool (*drop_permissions)(void)) {
+	struct cg_launcher *launcher = calloc(1, sizeof(struct cg_launcher));
+	size_t n = 0;
+	for(char **it = environ; *it != NULL; ++it) {
+		++n;
+	}
+	char **env = calloc(n + 1, sizeof(char *));
+	if(launcher == NULL || env == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for launcher");
+		free(launcher);
+		free(env);
+		return -1;
+	}
+	for(size_t i = 0; i < n; ++i) {
+		env[i] = strdup(environ[i]);
+		if(env[i] == NULL) {
+			wlr_log(WLR_ERROR, "Failed to allocate memory for launcher");
+			goto error;
+		}
+	}
+	launcher->env = env;
+
+	int fds[2];
+	if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) != 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to create launcher socket");
+		goto error;
+	}
+	fflush(NULL);
+	pid_t pid = fork();
+	if(pid == 0) {
+		close(fds[0]);
+		launcher_run(fds[1], drop_permissions);
+	}
+	close(fds[1]);
+	if(pid < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to fork launcher");
+		close(fds[0]);
+		goto error;
+	}
+	launcher->fd = fds[0];
+	launcher->pid = pid;
+	server->launcher = launcher;
+	return 0;
+
+error:
+	for(size_t i = 0; i < n; ++i) {
+		free(env[i]);
+	}
+	free(env);
+	free(launcher);
+	return -1;
+}
+
+static bool
+request_append(char *request, size_t *len, const char *str, size_t str_len) {
+	if(*len + str_len + 1 > CG_LAUNCHER_REQUEST_MAX) {
+		return false;
+	}
+	memcpy(request + *len, str, str_len);
+	request[*len + str_len] = '\0';
+	*len += str_len + 1;
+	return true;
+}
+
+/* Sends the command of child to the launcher along with the changes made
+ * to the environment since the launcher was started. On success, returns 0
+ * and adds child to the children of server. */
+int
+launcher_spawn(struct cg_server *server, struct cg_child *child) {
+	struct cg_launcher *launcher = server->launcher;
+	if(launcher->source == NULL) {
+		launcher->source =
+		    wl_event_loop_add_fd(server->event_loop, launcher->fd,
+		                         WL_EVENT_READABLE, handle_launcher_readable,
+		                         server);
+		if(launcher->source == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create launcher event source");
+			return -1;
+		}
+	}
+	char *request = malloc(CG_LAUNCHER_REQUEST_MAX);
+	if(request == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for launcher request");
+		return -1;
+	}
+
+	size_t len = 0;
+	bool fits =
+	    request_append(request, &len, child->command, strlen(child->command));
+	for(char **it = environ; fits && *it != NULL; ++it) {
+		char *old = env_find(launcher->env, *it);
+		if(old == NULL || strcmp(old, *it) != 0) {
+			fits = request_append(request, &len, *it, strlen(*it));
+		}
+	}
+	for(char **it = launcher->env; fits && *it != NULL; ++it) {
+		if(env_find(environ, *it) == NULL) {
+			fits = request_append(request, &len, *it, env_name_len(*it));
+		}
+	}
+	if(!fits) {
+		wlr_log(WLR_ERROR, "Command or environment too large for launcher");
+		free(request);
+		return -1;
+	}
+	if(send(launcher->fd, request, len, MSG_NOSIGNAL) != (ssize_t)len) {
+		wlr_log_errno(WLR_ERROR, "Failed to send command to launcher");
+		free(request);
+		return -1;
+	}
+	free(request);
+
+	child->launched = true;
+	wl_list_insert(server->children.prev, &child->link);
+	return 0;
+}
+
+void
+launcher_finish(struct cg_server *server) {
+	struct cg_launcher *launcher = server->launcher;
+	if(launcher == NULL) {
+		return;
+	}
+	if(launcher->source != NULL) {
+		wl_event_source_remove(launcher->source);
+	}
+	close(launcher->fd);
+	waitpid(launcher->pid, NULL, 0);
+	for(char **it = launcher->env; *it != NULL; ++it) {
+		free(*it);
+	}
+	free(launcher->env);
+	free(launcher);
+	server->launcher = NULL;
+
+	/* The exits of the children of the launcher are not reported anymore */
+	struct cg_child *child, *tmp;
+	wl_list_for_each_safe(child, tmp, &server->children, link) {
+		if(child->launched && child->pid == 0) {
+			spawn_child_destroy(child);
+		} else if(child->launched && !child->exited) {
+			spawn_child_exited(child);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_LAUNCHER_H
+#define CG_LAUNCHER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct cg_child;
+struct cg_server;
+struct wl_event_source;
+
+// Maximum size of a request, the command and the environment changes
+#define CG_LAUNCHER_REQUEST_MAX 65536
+
+enum cg_launcher_reply_type {
+	CG_LAUNCHER_SPAWNED, // pid is the spawned process, or -1 and err is set
+	CG_LAUNCHER_EXITED,  // pid has exited
+};
+
+struct cg_launcher_reply {
+	int32_t type; // enum cg_launcher_reply_type
+	int32_t pid;
+	int32_t err;
+};
+
+/* Helper process forked at startup which spawns the commands of "exec" */
+struct cg_launcher {
+	int fd;
+	pid_t pid;
+	char **env; // Environment of the helper
+	struct wl_event_source *source;
+};
+
+int
+launcher_start(struct cg_server *server, bool (*drop_permissions)(void));
+int
+launcher_spawn(struct cg_server *server, struct cg_child *child);
+void
+launcher_finish(struct cg_server *server);
+
+#endif
@@ -45,6 +45,7 @@ handle_layer_surface_map(struct wl_listener *listener,
 	        "Layer surface mapped: namespace=%s keyboard_interactive=%d",
 	        wlr_layer_surface->namespace,
 	        wlr_layer_surface->current.keyboard_interactive);
+	++layer_surface->server->scene_generation;
 
 	// Give keyboard focus if the layer surface wants it
 	if(wlr_layer_surface->current.keyboard_interactive ==
@@ -70,6 +71,7 @@ handle_layer_surface_unmap(struct wl_listener *listener,
 	    layer_surface->wlr_layer_surface;
 
 	wlr_log(WLR_DEBUG, "Layer surface unmapped");
+	++layer_surface->server->scene_generation;
 
 	// Clear keyboard focus if this layer surface had it
 	struct cg_seat *seat = layer_surface->server->seat;
@@ -105,6 +107,7 @@ handle_layer_surface_commit(struct wl_listener *listener,
 	    wl_container_of(listener, layer_surface, commit);
 	struct wlr_layer_surface_v1 *wlr_layer_surface =
 	    layer_surface->wlr_layer_surface;
+	++layer_surface->server->scene_generation;
 
 	// Configure on initial commit only - the scene helper handles the rest
 	if(wlr_layer_surface->initial_commit) {
@@ -8,6 +8,8 @@
 #include <libinput.h>
 #include <libudev.h>
 #include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <wlr/backend/libinput.h>
 #include <wlr/util/log.h>
@@ -262,8 +264,14 @@ input_device_get_type(struct cg_input_device *device) {
 	return "unknown";
 }
 
+/* A setting is applied if it is set and differs from the configuration which
+ * was applied before, if any */
+#define SETTING_CHANGED(field, unset)                                          \
+	(config->field != (unset) && (old == NULL || old->field != config->field))
+
 void
 apply_config_to_device(struct cg_input_config *config,
+                       struct cg_input_config *old,
                        struct cg_input_device *input_device) {
 
 	if(wlr_input_device_is_libinput(input_device->wlr_device)) {
@@ -287,65 +295,72 @@ apply_config_to_device(struct cg_input_config *config,
 			    libinput_device_config_send_events_get_default_mode(device));
 		}
 
-		if(config->tap != INT_MIN) {
+		if(SETTING_CHANGED(tap, INT_MIN)) {
 			set_tap(device, config->tap);
 		}
-		if(config->tap_button_map != INT_MIN) {
+		if(SETTING_CHANGED(tap_button_map, INT_MIN)) {
 			set_tap_button_map(device, config->tap_button_map);
 		}
-		if(config->drag != INT_MIN) {
+		if(SETTING_CHANGED(drag, INT_MIN)) {
 			set_tap_drag(device, config->drag);
 		}
-		if(config->drag_lock != INT_MIN) {
+		if(SETTING_CHANGED(drag_lock, INT_MIN)) {
 			set_tap_drag_lock(device, config->drag_lock);
 		}
-		if(config->pointer_accel != FLT_MIN) {
+		if(SETTING_CHANGED(pointer_accel, FLT_MIN)) {
 			set_accel_speed(device, config->pointer_accel);
 		}
-		if(config->accel_profile != INT_MIN) {
+		if(SETTING_CHANGED(accel_profile, INT_MIN)) {
 			set_accel_profile(device, config->accel_profile);
 		}
-		if(config->natural_scroll != INT_MIN) {
+		if(SETTING_CHANGED(natural_scroll, INT_MIN)) {
 			set_natural_scroll(device, config->natural_scroll);
 		}
-		if(config->left_handed != INT_MIN) {
+		if(SETTING_CHANGED(left_handed, INT_MIN)) {
 			set_left_handed(device, config->left_handed);
 		}
-		if(config->click_method != INT_MIN) {
+		if(SETTING_CHANGED(click_method, INT_MIN)) {
 			set_click_method(device, config->click_method);
 		}
-		if(config->middle_emulation != INT_MIN) {
+		if(SETTING_CHANGED(middle_emulation, INT_MIN)) {
 			set_middle_emulation(device, config->middle_emulation);
 		}
-		if(config->scroll_method != INT_MIN) {
+		if(SETTING_CHANGED(scroll_method, INT_MIN)) {
 			set_scroll_method(device, config->scroll_method);
 		}
-		if(config->scroll_button != INT_MIN) {
+		if(SETTING_CHANGED(scroll_button, INT_MIN)) {
 			set_scroll_button(device, config->scroll_button);
 		}
-		if(config->dwt != INT_MIN) {
+		if(SETTING_CHANGED(dwt, INT_MIN)) {
 			set_dwt(device, config->dwt);
 		}
-		if(config->calibration_matrix.configured) {
+		if(config->calibration_matrix.configured &&
+		   (old == NULL || !old->calibration_matrix.configured ||
+		    memcmp(old->calibration_matrix.matrix,
+		           config->calibration_matrix.matrix,
+		           sizeof(config->calibration_matrix.matrix)) != 0)) {
 			set_calibration_matrix(device, config->calibration_matrix.matrix);
 		}
 	}
 }
 
+/* Applies the settings of the effective configuration of the device which
+ * changed since it was last configured */
 void
 cg_input_configure_libinput_device(struct cg_input_device *input_device) {
-	struct cg_server *server = input_device->server;
-	struct cg_input_config *config = NULL;
-
-	wl_list_for_each(config, &server->input_config, link) {
-		const char *device_type = input_device_get_type(input_device);
-		if(strcmp(config->identifier, input_device->identifier) == 0 ||
-		   strcmp(config->identifier, "*") == 0 ||
-		   (strncmp(config->identifier, "type:", 5) == 0 &&
-		    strcmp(config->identifier + 5, device_type) == 0)) {
-			apply_config_to_device(config, input_device);
-		}
+	if(!wlr_input_device_is_libinput(input_device->wlr_device)) {
+		return;
+	}
+	struct cg_input_config *config = input_manager_effective_config(
+	    input_device->server, input_device->identifier, input_device->type);
+	if(config == NULL) {
+		wlr_log(WLR_ERROR, "Could not allocate input configuration for "
+		                   "merging.");
+		return;
 	}
+	apply_config_to_device(config, input_device->config, input_device);
+	free(input_device->config);
+	input_device->config = config;
 }
 
 bool
@@ -1,10 +1,15 @@
 // Copyright 2020 - 2026, project-repo and the cagebreak contributors
 // SPDX-License-Identifier: MIT
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <cairo/cairo.h>
 #include <drm_fourcc.h>
 #include <pango/pangocairo.h>
+#include <pixman.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-client.h>
 #include <wlr/backend.h>
@@ -22,6 +27,9 @@
 #include "server.h"
 #include "util.h"
 
+#define MESSAGE_WIDTH_PADDING 8
+#define MESSAGE_HEIGHT_PADDING 2
+
 struct msg_buffer {
 	struct wlr_buffer base;
 	void *data;
@@ -102,11 +110,10 @@ to_cairo_subpixel_order(const enum wl_output_subpixel subpixel) {
 	return CAIRO_SUBPIXEL_ORDER_DEFAULT;
 }
 
-struct msg_buffer *
-create_message_texture(const char *string, const struct cg_output *output) {
-	const int WIDTH_PADDING = 8;
-	const int HEIGHT_PADDING = 2;
-
+/* Renders string using the message configuration. The returned surface has
+ * to be destroyed by the caller. */
+static cairo_surface_t *
+render_message(const char *string, const struct cg_output *output) {
 	double scale = output->wlr_output->scale;
 	int width = 0;
 	int height = 0;
@@ -131,8 +138,8 @@ create_message_texture(const char *string, const struct cg_output *output) {
 	cairo_set_font_options(c, fo);
 	get_text_size(c, output->server->message_config.font, &width, &height, NULL,
 	              scale, "%s", string);
-	width += 2 * WIDTH_PADDING;
-	height += 2 * HEIGHT_PADDING;
+	width += 2 * MESSAGE_WIDTH_PADDING;
+	height += 2 * MESSAGE_HEIGHT_PADDING;
 	cairo_surface_destroy(dummy_surface);
 	cairo_destroy(c);
 
@@ -149,20 +156,31 @@ create_message_texture(const char *string, const struct cg_output *output) {
 	cairo_set_line_width(cairo, 2);
 	cairo_rectangle(cairo, 0, 0, width, height);
 	cairo_stroke(cairo);
-	cairo_move_to(cairo, WIDTH_PADDING, HEIGHT_PADDING);
+	cairo_move_to(cairo, MESSAGE_WIDTH_PADDING, MESSAGE_HEIGHT_PADDING);
 
 	pango_printf(cairo, output->server->message_config.font, scale, "%s",
 	             string);
 
 	cairo_surface_flush(surface);
+	cairo_destroy(cairo);
+	cairo_font_options_destroy(fo);
+	return surface;
+}
+
+struct msg_buffer *
+create_message_texture(const char *string, const struct cg_output *output) {
+	cairo_surface_t *surface = render_message(string, output);
+	if(surface == NULL) {
+		return NULL;
+	}
 	unsigned char *data = cairo_image_surface_get_data(surface);
+	int width = cairo_image_surface_get_width(surface);
+	int height = cairo_image_surface_get_height(surface);
 	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
 
 	struct msg_buffer *buf = msg_buffer_create(width, height, stride);
 	if(buf == NULL) {
 		cairo_surface_destroy(surface);
-		cairo_destroy(cairo);
-		cairo_font_options_destroy(fo);
 		return NULL;
 	}
 	void *data_ptr;
@@ -172,8 +190,6 @@ create_message_texture(const char *string, const struct cg_output *output) {
 	                                     &data_ptr, NULL, NULL)) {
 		wlr_log(WLR_ERROR, "Failed to get pointer access to message buffer");
 		cairo_surface_destroy(surface);
-		cairo_destroy(cairo);
-		cairo_font_options_destroy(fo);
 		msg_buffer_destroy(&buf->base);
 		return NULL;
 	}
@@ -181,8 +197,6 @@ create_message_texture(const char *string, const struct cg_output *output) {
 	wlr_buffer_end_data_ptr_access(&buf->base);
 
 	cairo_surface_destroy(surface);
-	cairo_destroy(cairo);
-	cairo_font_options_destroy(fo);
 	return buf;
 }
 
@@ -258,6 +272,7 @@ message_set_output(struct cg_output *output, const char *string,
 	    &message->message->node,
 	    message->position->x + output_get_layout_box(output).x,
 	    message->position->y + output_get_layout_box(output).y);
+	++output->server->scene_generation;
 }
 
 void
@@ -344,6 +359,9 @@ message_printf_pos(struct cg_output *output, struct wlr_box *position,
 
 void
 message_clear(struct cg_output *output) {
+	/* This runs on every keybinding, keep the hit tests if nothing is
+	 * removed */
+	bool changed = !wl_list_empty(&output->messages);
 	struct cg_message *message, *tmp;
 	wl_list_for_each_safe(message, tmp, &output->messages, link) {
 		wl_list_remove(&message->link);
@@ -354,4 +372,631 @@ message_clear(struct cg_output *output) {
 		}
 		free(message);
 	}
+	for(int i = 0; i < CG_INDICATOR_COUNT; ++i) {
+		struct wlr_scene_buffer *node = output->indicators[i].node;
+		if(node != NULL && node->node.enabled) {
+			wlr_scene_node_set_enabled(&node->node, false);
+			changed = true;
+		}
+	}
+	if(changed) {
+		++output->server->scene_generation;
+	}
+}
+
+/* Computes the layout coordinates of a width x height box placed at anchor
+ * on output */
+static void
+anchor_position(struct cg_output *output, enum cg_message_anchor anchor,
+                int width, int height, int *x, int *y) {
+	struct wlr_box output_box = output_get_layout_box(output);
+	*x = output_box.x;
+	*y = output_box.y;
+	switch(anchor) {
+	case CG_MESSAGE_TOP_CENTER:
+	case CG_MESSAGE_BOTTOM_CENTER:
+	case CG_MESSAGE_CENTER:
+		*x += (output_box.width - width) / 2;
+		break;
+	case CG_MESSAGE_TOP_RIGHT:
+	case CG_MESSAGE_BOTTOM_RIGHT:
+		*x += output_box.width - width;
+		break;
+	default:
+		break;
+	}
+	switch(anchor) {
+	case CG_MESSAGE_BOTTOM_LEFT:
+	case CG_MESSAGE_BOTTOM_CENTER:
+	case CG_MESSAGE_BOTTOM_RIGHT:
+		*y += output_box.height - height;
+		break;
+	case CG_MESSAGE_CENTER:
+		*y += (output_box.height - height) / 2;
+		break;
+	default:
+		break;
+	}
+}
+
+static const char *indicator_labels[CG_INDICATOR_COUNT] = {
+    [CG_INDICATOR_TILE] = "Current tile",
+    [CG_INDICATOR_OUTPUT] = "Current Output",
+};
+
+/* Returns true if the indicator was shown */
+static bool
+indicator_destroy(struct cg_indicator *indicator) {
+	bool shown = false;
+	if(indicator->node != NULL) {
+		shown = indicator->node->node.enabled;
+		wlr_scene_node_destroy(&indicator->node->node);
+		indicator->node = NULL;
+	}
+	if(indicator->buf != NULL) {
+		msg_buffer_destroy(&indicator->buf->base);
+		indicator->buf = NULL;
+	}
+	return shown;
+}
+
+/* Show the focus indicator of the given kind. If tile is not NULL, the
+ * indicator is centered on it, otherwise it is placed according to the
+ * message anchor. */
+void
+message_indicator(struct cg_output *output, enum cg_indicator_kind kind,
+                  const struct wlr_box *tile) {
+	struct cg_message_config *config = &output->server->message_config;
+	if(output->destroyed || config->enabled == 0 ||
+	   config->focus_indicator == 0) {
+		return;
+	}
+	struct cg_indicator *indicator = &output->indicators[kind];
+	float scale = output->wlr_output->scale;
+	if(indicator->node != NULL && indicator->scale != scale) {
+		indicator_destroy(indicator);
+	}
+	bool changed = indicator->node == NULL;
+	if(indicator->node == NULL) {
+		indicator->buf = create_message_texture(indicator_labels[kind], output);
+		if(indicator->buf == NULL) {
+			wlr_log(WLR_ERROR, "Could not create focus indicator texture");
+			return;
+		}
+		indicator->node = wlr_scene_buffer_create(&output->server->scene->tree,
+		                                          &indicator->buf->base);
+		if(indicator->node == NULL) {
+			wlr_log(WLR_ERROR, "Could not create focus indicator node");
+			indicator_destroy(indicator);
+			return;
+		}
+		indicator->scale = scale;
+	}
+
+	int width = indicator->buf->base.width / scale;
+	int height = indicator->buf->base.height / scale;
+	int x, y;
+	if(tile != NULL) {
+		struct wlr_box output_box = output_get_layout_box(output);
+		x = output_box.x + tile->x + tile->width / 2 - width / 2;
+		y = output_box.y + tile->y + tile->height / 2 - height / 2;
+	} else {
+		anchor_position(output, config->anchor, width, height, &x, &y);
+	}
+	struct wlr_scene_node *node = &indicator->node->node;
+	changed = changed || !node->enabled || node->x != x || node->y != y ||
+	          node->link.next != &node->parent->children;
+	wlr_scene_buffer_set_dest_size(indicator->node, width, height);
+	wlr_scene_node_set_position(node, x, y);
+	wlr_scene_node_raise_to_top(node);
+	wlr_scene_node_set_enabled(node, true);
+	if(changed) {
+		++output->server->scene_generation;
+	}
+	alarm(config->display_time);
+}
+
+void
+message_indicator_clear(struct cg_output *output) {
+	bool changed = false;
+	for(int i = 0; i < CG_INDICATOR_COUNT; ++i) {
+		changed = indicator_destroy(&output->indicators[i]) || changed;
+	}
+	if(changed) {
+		++output->server->scene_generation;
+	}
+}
+
+static struct cg_overlay *
+overlay_find(struct cg_output *output, const char *name) {
+	struct cg_overlay *overlay;
+	wl_list_for_each(overlay, &output->overlays, link) {
+		if(strcmp(overlay->name, name) == 0) {
+			return overlay;
+		}
+	}
+	return NULL;
+}
+
+static void
+overlay_place(struct cg_overlay *overlay) {
+	int width = overlay->buf->base.width / overlay->scale;
+	int height = overlay->buf->base.height / overlay->scale;
+	int x, y;
+	anchor_position(overlay->output, overlay->anchor, width, height, &x, &y);
+	wlr_scene_buffer_set_dest_size(overlay->node, width, height);
+	wlr_scene_node_set_position(&overlay->node->node, x, y);
+	++overlay->output->server->scene_generation;
+}
+
+/* State kept to draw an overlay in place: the layout of its text and a cairo
+ * context drawing into the data of its buffer */
+struct cg_overlay_canvas {
+	PangoLayout *layout;
+	cairo_font_options_t *font_options;
+	cairo_surface_t *surface; // Wraps the data of cg_overlay::buf, or NULL
+	cairo_t *cairo;
+};
+
+static void
+overlay_canvas_unbind(struct cg_overlay_canvas *canvas) {
+	if(canvas->cairo != NULL) {
+		cairo_destroy(canvas->cairo);
+		canvas->cairo = NULL;
+	}
+	if(canvas->surface != NULL) {
+		cairo_surface_destroy(canvas->surface);
+		canvas->surface = NULL;
+	}
+}
+
+static void
+overlay_canvas_destroy(struct cg_overlay_canvas *canvas) {
+	overlay_canvas_unbind(canvas);
+	if(canvas->layout != NULL) {
+		g_object_unref(canvas->layout);
+	}
+	if(canvas->font_options != NULL) {
+		cairo_font_options_destroy(canvas->font_options);
+	}
+	free(canvas);
+}
+
+/* Creates a canvas with an empty layout in the font and at the scale of
+ * output */
+static struct cg_overlay_canvas *
+overlay_canvas_create(const struct cg_output *output) {
+	struct cg_overlay_canvas *canvas =
+	    calloc(1, sizeof(struct cg_overlay_canvas));
+	if(canvas == NULL) {
+		return NULL;
+	}
+	canvas->font_options = cairo_font_options_create();
+	cairo_font_options_set_hint_style(canvas->font_options,
+	                                  CAIRO_HINT_STYLE_FULL);
+	cairo_font_options_set_antialias(canvas->font_options,
+	                                 CAIRO_ANTIALIAS_SUBPIXEL);
+	cairo_font_options_set_subpixel_order(
+	    canvas->font_options,
+	    to_cairo_subpixel_order(output->wlr_output->subpixel));
+
+	cairo_surface_t *dummy_surface =
+	    cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 0, 0);
+	// This occurs when we are fuzzing. In that case, do nothing
+	if(dummy_surface == NULL) {
+		overlay_canvas_destroy(canvas);
+		return NULL;
+	}
+	cairo_t *cairo = cairo_create(dummy_surface);
+	canvas->layout =
+	    get_pango_layout(cairo, output->server->message_config.font, "",
+	                     output->wlr_output->scale);
+	pango_cairo_context_set_font_options(
+	    pango_layout_get_context(canvas->layout), canvas->font_options);
+	pango_cairo_update_layout(cairo, canvas->layout);
+	cairo_destroy(cairo);
+	cairo_surface_destroy(dummy_surface);
+	return canvas;
+}
+
+/* Lets the canvas draw into the data of buf */
+static bool
+overlay_canvas_bind(struct cg_overlay_canvas *canvas, struct msg_buffer *buf) {
+	overlay_canvas_unbind(canvas);
+	canvas->surface = cairo_image_surface_create_for_data(
+	    buf->data, CAIRO_FORMAT_ARGB32, buf->base.width, buf->base.height,
+	    buf->stride);
+	canvas->cairo = cairo_create(canvas->surface);
+	if(cairo_status(canvas->cairo) != CAIRO_STATUS_SUCCESS) {
+		overlay_canvas_unbind(canvas);
+		return false;
+	}
+	cairo_set_antialias(canvas->cairo, CAIRO_ANTIALIAS_BEST);
+	cairo_set_font_options(canvas->cairo, canvas->font_options);
+	return true;
+}
+
+/* Draws the overlay into its buffer as render_message would. If clip is not
+ * NULL, only the pixels in clip are drawn, which must not cover the
+ * border. */
+static void
+overlay_draw(struct cg_overlay *overlay, const struct wlr_box *clip) {
+	struct cg_overlay_canvas *canvas = overlay->canvas;
+	struct cg_message_config *config = &overlay->output->server->message_config;
+	cairo_t *cairo = canvas->cairo;
+	cairo_save(cairo);
+	if(clip != NULL) {
+		cairo_rectangle(cairo, clip->x, clip->y, clip->width, clip->height);
+		cairo_clip(cairo);
+	}
+	float *bg_col = config->bg_color;
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_rgba(cairo, bg_col[0], bg_col[1], bg_col[2], bg_col[3]);
+	cairo_paint(cairo);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_OVER);
+	float *fg_col = config->fg_color;
+	cairo_set_source_rgba(cairo, fg_col[0], fg_col[1], fg_col[2], fg_col[3]);
+	if(clip == NULL) {
+		cairo_set_line_width(cairo, 2);
+		cairo_rectangle(cairo, 0, 0, overlay->buf->base.width,
+		                overlay->buf->base.height);
+		cairo_stroke(cairo);
+	}
+	cairo_move_to(cairo, MESSAGE_WIDTH_PADDING, MESSAGE_HEIGHT_PADDING);
+	pango_cairo_update_layout(cairo, canvas->layout);
+	pango_cairo_show_layout(cairo, canvas->layout);
+	cairo_restore(cairo);
+	cairo_surface_flush(canvas->surface);
+}
+
+/* Computes the bytes which differ between old and new, which are those from
+ * prefix to old_end in old and from prefix to new_end in new. The bounds
+ * are moved to the start of UTF-8 sequences. */
+static void
+text_diff(const char *old, const char *new, int *prefix, int *old_end,
+          int *new_end) {
+	int old_len = strlen(old), new_len = strlen(new);
+	int start = 0;
+	while(start < old_len && start < new_len && old[start] == new[start]) {
+		++start;
+	}
+	while(start > 0 && (new[start] & 0xc0) == 0x80) {
+		--start;
+	}
+	int suffix = 0;
+	while(suffix < old_len - start && suffix < new_len - start &&
+	      old[old_len - suffix - 1] == new[new_len - suffix - 1]) {
+		++suffix;
+	}
+	while(suffix > 0 && (new[new_len - suffix] & 0xc0) == 0x80) {
+		--suffix;
+	}
+	*prefix = start;
+	*old_end = old_len - suffix;
+	*new_end = new_len - suffix;
+}
+
+/* Returns the horizontal position in Pango units of the byte index of the
+ * single line layout */
+static int
+layout_index_x(PangoLayout *layout, int index) {
+	if(index >= (int)strlen(pango_layout_get_text(layout))) {
+		int width;
+		pango_layout_get_size(layout, &width, NULL);
+		return width;
+	}
+	PangoRectangle pos;
+	pango_layout_index_to_pos(layout, index, &pos);
+	return pos.width < 0 ? pos.x + pos.width : pos.x;
+}
+
+/* Draw text into the overlay. Unless force is set, nothing is drawn if the
+ * text did not change. The layout and the buffer of the overlay are kept
+ * across updates. If the size of the text stays the same and it is a single
+ * line, only the run of glyphs which changed and those after it, if they
+ * moved, are drawn again and damaged. */
+static int
+overlay_render(struct cg_overlay *overlay, const char *text, bool force) {
+	if(overlay->node != NULL && !force && strcmp(overlay->text, text) == 0) {
+		overlay_place(overlay);
+		return 0;
+	}
+	char *new_text = strdup(text);
+	if(new_text == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate text of overlay \"%s\"",
+		        overlay->name);
+		return -1;
+	}
+
+	/* The layout depends on the font and the scale */
+	float scale = overlay->output->wlr_output->scale;
+	if(overlay->canvas != NULL && (force || overlay->scale != scale)) {
+		overlay_canvas_destroy(overlay->canvas);
+		overlay->canvas = NULL;
+	}
+	struct cg_overlay_canvas *canvas = overlay->canvas;
+	/* Only the text changed if the canvas is kept */
+	bool partial = canvas != NULL && strchr(overlay->text, '\n') == NULL &&
+	               strchr(new_text, '\n') == NULL;
+	if(canvas == NULL) {
+		canvas = overlay_canvas_create(overlay->output);
+		if(canvas == NULL) {
+			free(new_text);
+			return -1;
+		}
+		overlay->canvas = canvas;
+	}
+
+	int prefix, old_end, new_end;
+	text_diff(overlay->text, new_text, &prefix, &old_end, &new_end);
+	int old_x0 = 0, old_x1 = 0;
+	if(partial) {
+		old_x0 = layout_index_x(canvas->layout, prefix);
+		old_x1 = layout_index_x(canvas->layout, old_end);
+	}
+	pango_layout_set_text(canvas->layout, new_text, -1);
+	free(overlay->text);
+	overlay->text = new_text;
+	overlay->scale = scale;
+
+	int width, height;
+	pango_layout_get_pixel_size(canvas->layout, &width, &height);
+	width += 2 * MESSAGE_WIDTH_PADDING;
+	height += 2 * MESSAGE_HEIGHT_PADDING;
+
+	struct msg_buffer *buf = overlay->buf;
+	if(buf != NULL && buf->base.width == width &&
+	   buf->base.height == height) {
+		if(canvas->surface == NULL && !overlay_canvas_bind(canvas, buf)) {
+			wlr_log(WLR_ERROR, "Failed to draw overlay \"%s\"", overlay->name);
+			return -1;
+		}
+		struct wlr_box clip = {0, 0, width, height};
+		if(partial) {
+			int new_x0 = layout_index_x(canvas->layout, prefix);
+			int new_x1 = layout_index_x(canvas->layout, new_end);
+			int x0 = old_x0 < new_x0 ? old_x0 : new_x0;
+			int x1 = old_x1 > new_x1 ? old_x1 : new_x1;
+			if(old_x1 != new_x1) {
+				/* The glyphs after the run moved */
+				pango_layout_get_size(canvas->layout, &x1, NULL);
+			}
+			/* Leave some room for glyphs reaching beyond their extent, but
+			 * keep the border */
+			int left =
+			    MESSAGE_WIDTH_PADDING + PANGO_PIXELS_FLOOR(x0) - height / 2;
+			int right =
+			    MESSAGE_WIDTH_PADDING + PANGO_PIXELS_CEIL(x1) + height / 2;
+			clip.x = left > 1 ? left : 1;
+			clip.y = 1;
+			clip.width = (right < width - 1 ? right : width - 1) - clip.x;
+			clip.height = height - 2;
+		}
+		if(clip.width > 0) {
+			if(!wlr_buffer_begin_data_ptr_access(
+			       &buf->base, WLR_BUFFER_DATA_PTR_ACCESS_WRITE, NULL, NULL,
+			       NULL)) {
+				wlr_log(WLR_ERROR, "Failed to get pointer access to overlay");
+				return -1;
+			}
+			overlay_draw(overlay, partial ? &clip : NULL);
+			wlr_buffer_end_data_ptr_access(&buf->base);
+			pixman_region32_t damage;
+			pixman_region32_init_rect(&damage, clip.x, clip.y, clip.width,
+			                          clip.height);
+			wlr_scene_buffer_set_buffer_with_damage(overlay->node, &buf->base,
+			                                        &damage);
+			pixman_region32_fini(&damage);
+		}
+		overlay_place(overlay);
+		return 0;
+	}
+
+	size_t stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+	struct msg_buffer *new_buf = msg_buffer_create(width, height, stride);
+	if(new_buf == NULL || !overlay_canvas_bind(canvas, new_buf)) {
+		wlr_log(WLR_ERROR, "Failed to allocate buffer for overlay \"%s\"",
+		        overlay->name);
+		if(new_buf != NULL) {
+			msg_buffer_destroy(&new_buf->base);
+		}
+		return -1;
+	}
+	overlay->buf = new_buf;
+	if(wlr_buffer_begin_data_ptr_access(&new_buf->base,
+	                                    WLR_BUFFER_DATA_PTR_ACCESS_WRITE, NULL,
+	                                    NULL, NULL)) {
+		overlay_draw(overlay, NULL);
+		wlr_buffer_end_data_ptr_access(&new_buf->base);
+	}
+	if(overlay->node == NULL) {
+		overlay->node = wlr_scene_buffer_create(
+		    &overlay->output->server->scene->tree, &new_buf->base);
+		if(overlay->node == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create scene node for overlay");
+			overlay_canvas_unbind(canvas);
+			overlay->buf = buf;
+			msg_buffer_destroy(&new_buf->base);
+			return -1;
+		}
+		wlr_scene_node_raise_to_top(&overlay->node->node);
+	} else {
+		wlr_scene_buffer_set_buffer(overlay->node, &new_buf->base);
+	}
+	if(buf != NULL) {
+		msg_buffer_destroy(&buf->base);
+	}
+	overlay_place(overlay);
+	return 0;
+}
+
+static int
+overlay_render_clock(struct cg_overlay *overlay, bool force) {
+	char text[256];
+	time_t now = time(NULL);
+	struct tm tm;
+	if(localtime_r(&now, &tm) == NULL ||
+	   strftime(text, sizeof(text), overlay->format, &tm) == 0) {
+		wlr_log(WLR_ERROR, "Unable to format the time for overlay \"%s\"",
+		        overlay->name);
+		return -1;
+	}
+	return overlay_render(overlay, text, force);
+}
+
+static void
+overlay_schedule_clock(struct cg_server *server);
+
+static int
+handle_overlay_clock(void *data) {
+	struct cg_server *server = data;
+	bool have_clock = false;
+	struct cg_output *output;
+	wl_list_for_each(output, &server->outputs, link) {
+		struct cg_overlay *overlay;
+		wl_list_for_each(overlay, &output->overlays, link) {
+			if(overlay->format != NULL) {
+				have_clock = true;
+				overlay_render_clock(overlay, false);
+			}
+		}
+	}
+	if(have_clock) {
+		overlay_schedule_clock(server);
+	}
+	return 0;
+}
+
+static void
+overlay_schedule_clock(struct cg_server *server) {
+	if(server->overlay_clock == NULL) {
+		server->overlay_clock = wl_event_loop_add_timer(
+		    server->event_loop, handle_overlay_clock, server);
+		if(server->overlay_clock == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create timer for overlay clocks");
+			return;
+		}
+	}
+	/* Wake up right after the next full second, so that the displayed time
+	 * does not lag behind */
+	struct timespec now = {0};
+	clock_gettime(CLOCK_REALTIME, &now);
+	wl_event_source_timer_update(server->overlay_clock,
+	                             1000 - now.tv_nsec / 1000000);
+}
+
+static void
+overlay_destroy(struct cg_overlay *overlay) {
+	++overlay->output->server->scene_generation;
+	wl_list_remove(&overlay->link);
+	if(overlay->node != NULL) {
+		wlr_scene_node_destroy(&overlay->node->node);
+	}
+	if(overlay->canvas != NULL) {
+		overlay_canvas_destroy(overlay->canvas);
+	}
+	if(overlay->buf != NULL) {
+		msg_buffer_destroy(&overlay->buf->base);
+	}
+	free(overlay->name);
+	free(overlay->text);
+	free(overlay->format);
+	free(overlay);
+}
+
+int
+overlay_set(struct cg_output *output, const char *name,
+            enum cg_message_anchor anchor, const char *text,
+            const char *format) {
+	if(output->destroyed) {
+		return -1;
+	}
+	struct cg_overlay *overlay = overlay_find(output, name);
+	if(overlay == NULL) {
+		overlay = calloc(1, sizeof(struct cg_overlay));
+		if(overlay == NULL) {
+			wlr_log(WLR_ERROR, "Error allocating overlay structure");
+			return -1;
+		}
+		overlay->name = strdup(name);
+		overlay->text = strdup("");
+		if(overlay->name == NULL || overlay->text == NULL) {
+			wlr_log(WLR_ERROR, "Error allocating overlay structure");
+			free(overlay->name);
+			free(overlay->text);
+			free(overlay);
+			return -1;
+		}
+		overlay->output = output;
+		wl_list_insert(&output->overlays, &overlay->link);
+	}
+	overlay->anchor = anchor;
+
+	free(overlay->format);
+	overlay->format = NULL;
+	int ret = -1;
+	if(format == NULL) {
+		ret = overlay_render(overlay, text, false);
+	} else if((overlay->format = strdup(format)) != NULL) {
+		ret = overlay_render_clock(overlay, false);
+		overlay_schedule_clock(output->server);
+	} else {
+		wlr_log(WLR_ERROR, "Error allocating overlay clock format");
+	}
+	/* Don't keep overlays around which were never drawn */
+	if(ret != 0 && overlay->node == NULL) {
+		overlay_destroy(overlay);
+	}
+	return ret;
+}
+
+int
+overlay_remove(struct cg_output *output, const char *name) {
+	struct cg_overlay *overlay = overlay_find(output, name);
+	if(overlay == NULL) {
+		return -1;
+	}
+	overlay_destroy(overlay);
+	return 0;
+}
+
+/* Draws the overlays of output again if force is set or the scale of output
+ * changed since they were drawn, and moves them to their anchor */
+void
+overlay_update(struct cg_output *output, bool force) {
+	if(output->destroyed) {
+		return;
+	}
+	struct cg_overlay *overlay;
+	wl_list_for_each(overlay, &output->overlays, link) {
+		if(overlay->node == NULL) {
+			continue;
+		}
+		bool redraw = force || overlay->scale != output->wlr_output->scale;
+		if(!redraw) {
+			overlay_place(overlay);
+		} else if(overlay->format != NULL) {
+			overlay_render_clock(overlay, true);
+		} else {
+			overlay_render(overlay, overlay->text, true);
+		}
+	}
+}
+
+void
+overlay_raise(struct cg_output *output) {
+	struct cg_overlay *overlay;
+	wl_list_for_each_reverse(overlay, &output->overlays, link) {
+		if(overlay->node != NULL) {
+			wlr_scene_node_raise_to_top(&overlay->node->node);
+		}
+	}
+}
+
+void
+overlay_clear(struct cg_output *output) {
+	struct cg_overlay *overlay, *tmp;
+	wl_list_for_each_safe(overlay, tmp, &output->overlays, link) {
+		overlay_destroy(overlay);
+	}
 }
@@ -5,9 +5,12 @@
 
 #define MESSAGE_H
 
+#include <stdbool.h>
 #include <wayland-server-core.h>
 
 struct cg_output;
+struct cg_overlay_canvas;
+struct cg_server;
 struct wlr_box;
 struct wlr_buffer;
 
@@ -28,6 +31,7 @@ struct cg_message_config {
 	float bg_color[4];
 	float fg_color[4];
 	int enabled;
+	int focus_indicator;
 	enum cg_message_anchor anchor;
 };
 
@@ -39,6 +43,46 @@ struct cg_message {
 	struct wl_list link;
 };
 
+enum cg_indicator_kind {
+	CG_INDICATOR_TILE,
+	CG_INDICATOR_OUTPUT,
+	CG_INDICATOR_COUNT
+};
+
+/* The focus indicators are rendered once and then only moved and shown or
+ * hidden. They are rendered again if the scale of the output or the message
+ * configuration changes. */
+struct cg_indicator {
+	struct wlr_scene_buffer *node;
+	struct msg_buffer *buf;
+	float scale;
+};
+
+enum cg_overlay_action { CG_OVERLAY_SET, CG_OVERLAY_CLOCK, CG_OVERLAY_REMOVE };
+
+struct cg_overlay_config {
+	enum cg_overlay_action action;
+	enum cg_message_anchor anchor;
+	char *name;
+	char *text; // Text to display or strftime format for CG_OVERLAY_CLOCK
+};
+
+/* Overlays are persistent messages which are identified by their name. In
+ * contrast to messages, they keep their scene node and buffer across updates
+ * and are not removed by message_clear. */
+struct cg_overlay {
+	char *name;
+	char *text;
+	char *format; // strftime format if the overlay is a clock, NULL otherwise
+	enum cg_message_anchor anchor;
+	struct cg_output *output;
+	struct wlr_scene_buffer *node;
+	struct msg_buffer *buf;
+	struct cg_overlay_canvas *canvas; // Drawing state of buf, see message.c
+	float scale; // Scale of the output when buf was drawn
+	struct wl_list link; // cg_output::overlays
+};
+
 void
 message_printf(struct cg_output *output, const char *fmt, ...);
 void
@@ -46,5 +90,22 @@ message_printf_pos(struct cg_output *output, struct wlr_box *position,
                    enum cg_message_anchor, const char *fmt, ...);
 void
 message_clear(struct cg_output *output);
+void
+message_indicator(struct cg_output *output, enum cg_indicator_kind kind,
+                  const struct wlr_box *tile);
+void
+message_indicator_clear(struct cg_output *output);
+int
+overlay_set(struct cg_output *output, const char *name,
+            enum cg_message_anchor anchor, const char *text,
+            const char *format);
+int
+overlay_remove(struct cg_output *output, const char *name);
+void
+overlay_update(struct cg_output *output, bool force);
+void
+overlay_raise(struct cg_output *output);
+void
+overlay_clear(struct cg_output *output);
 
 #endif /* end of include guard MESSAGE_H */
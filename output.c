@@ -32,11 +32,13 @@
 #include <wlr/xwayland.h>
 #endif
 
+#include "deferred_init.h"
 #include "keybinding.h"
 #include "message.h"
 #include "output.h"
 #include "seat.h"
 #include "server.h"
+#include "startup_trace.h"
 #include "util.h"
 #include "view.h"
 #include "workspace.h"
@@ -57,6 +59,8 @@ output_clear(struct cg_output *output) {
 	wl_list_remove(&output->link);
 
 	message_clear(output);
+	overlay_clear(output);
+	message_indicator_clear(output);
 
 	struct cg_view *view, *view_tmp;
 	if(server->running) {
@@ -140,6 +144,11 @@ output_destroy(struct cg_output *output) {
 		wl_list_remove(&output->destroy.link);
 		wl_list_remove(&output->commit.link);
 		wl_list_remove(&output->frame.link);
+		wl_list_remove(&output->present.link);
+		if(output->render_timer != NULL) {
+			wl_event_source_remove(output->render_timer);
+			output->render_timer = NULL;
+		}
 
 		// Destroy layer shell scene trees
 		if(output->layer_shell_background) {
@@ -248,24 +257,118 @@ handle_output_gamma_control_set_gamma(struct wl_listener *listener,
 }
 
 static void
-handle_output_frame(struct wl_listener *listener,
-                    __attribute__((unused)) void *data) {
-	struct cg_output *output = wl_container_of(listener, output, frame);
+output_render(struct cg_output *output) {
 	if(!output->wlr_output->enabled) {
 		return;
 	}
+	if(output == output->server->curr_output && output->server->seat != NULL) {
+		seat_schedule_key_repeats(output->server->seat);
+	}
 	struct wlr_scene_output *scene_output =
 	    wlr_scene_get_scene_output(output->server->scene, output->wlr_output);
 	if(scene_output == NULL) {
 		return;
 	}
-	wlr_scene_output_commit(scene_output, NULL);
+	struct timespec commit = {0}, now = {0};
+	struct cg_frame_sample sample = {0};
+	sample.frame_ns = output->frame_ns;
+	sample.skipped = !wlr_scene_output_needs_frame(scene_output);
 
-	struct timespec now = {0};
+	clock_gettime(CLOCK_MONOTONIC, &commit);
+	if(!wlr_scene_output_commit(scene_output, NULL)) {
+		sample.skipped = true;
+	}
 	clock_gettime(CLOCK_MONOTONIC, &now);
+	sample.commit_ns = timespec_to_ns(&now) - timespec_to_ns(&commit);
+	sample.to_commit_ns = timespec_to_ns(&now) - sample.frame_ns;
+	frame_stats_record(&output->frame_stats, &sample);
+	if(!sample.skipped && output->workspaces != NULL) {
+		view_latency_drawn(output, timespec_to_ns(&commit));
+	}
+
 	wlr_scene_output_send_frame_done(scene_output, &now);
 }
 
+static int
+handle_render_timer(void *data) {
+	struct cg_output *output = data;
+	output_render(output);
+	return 0;
+}
+
+/* Returns the number of milliseconds by which the commit of the current frame
+ * can be delayed without missing the next vblank, 0 if it cannot */
+static int
+output_render_delay(struct cg_output *output) {
+	if(output->max_render_time == 0 || output->wlr_output->refresh <= 0) {
+		return 0;
+	}
+	uint64_t refresh_ns = 1000000000000ULL / output->wlr_output->refresh;
+	uint64_t budget_ns;
+	if(output->max_render_time == CG_MAX_RENDER_TIME_AUTO) {
+		uint64_t predicted = frame_stats_predict_commit(&output->frame_stats);
+		if(predicted == 0) {
+			return 0;
+		}
+		budget_ns = predicted + CG_RENDER_TIME_SLACK_NS;
+	} else {
+		budget_ns = (uint64_t)output->max_render_time * 1000000;
+	}
+	if(budget_ns >= refresh_ns) {
+		return 0;
+	}
+	/* The event loop timers only have a resolution of one millisecond, so
+	 * round down to make sure that we are not late */
+	return (refresh_ns - budget_ns) / 1000000;
+}
+
+static void
+handle_output_frame(struct wl_listener *listener,
+                    __attribute__((unused)) void *data) {
+	struct cg_output *output = wl_container_of(listener, output, frame);
+	if(!output->wlr_output->enabled) {
+		return;
+	}
+	struct timespec frame = {0};
+	clock_gettime(CLOCK_MONOTONIC, &frame);
+	output->frame_ns = timespec_to_ns(&frame);
+
+	int delay = output_render_delay(output);
+	if(delay > 0 && output->render_timer == NULL) {
+		output->render_timer = wl_event_loop_add_timer(
+		    output->server->event_loop, handle_render_timer, output);
+		if(output->render_timer == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create render timer for output %s",
+			        output->name);
+		}
+	}
+	if(delay > 0 && output->render_timer != NULL) {
+		wl_event_source_timer_update(output->render_timer, delay);
+	} else {
+		output_render(output);
+	}
+}
+
+static void
+handle_output_present(struct wl_listener *listener, void *data) {
+	struct cg_output *output = wl_container_of(listener, output, present);
+	struct wlr_output_event_present *event = data;
+	if(!event->presented) {
+		return;
+	}
+	uint64_t when_ns = timespec_to_ns(&event->when);
+	frame_stats_presented(&output->frame_stats, when_ns);
+	if(output->server->startup_trace != NULL) {
+		startup_trace_milestone(output->server, CG_STARTUP_FIRST_FRAME);
+	}
+	if(output->server->defer_init) {
+		deferred_init_schedule(output->server);
+	}
+	if(output->workspaces != NULL) {
+		view_latency_presented(output, when_ns);
+	}
+}
+
 static int
 output_set_mode(struct wlr_output *output, struct wlr_output_state *state,
                 int width, int height, float refresh_rate) {
@@ -361,6 +464,8 @@ output_apply_config(struct cg_server *server, struct cg_output *output,
 		return;
 	}
 	wlr_output_state_init(state);
+	++server->scene_generation;
+	++server->layout_generation;
 	struct wlr_box prev_box;
 	prev_box.x = output->layout_box.x;
 	prev_box.y = output->layout_box.y;
@@ -386,6 +491,9 @@ output_apply_config(struct cg_server *server, struct cg_output *output,
 	if(config->angle != -1) {
 		wlr_output_state_set_transform(state, config->angle);
 	}
+	if(config->max_render_time != -1) {
+		output->max_render_time = config->max_render_time;
+	}
 	if(config->scale != -1 && config->scale <= 10) {
 		wlr_log(WLR_INFO, "Setting output scale to %f", config->scale);
 		wlr_output_state_set_scale(state, config->scale);
@@ -439,6 +547,7 @@ output_apply_config(struct cg_server *server, struct cg_output *output,
 						}
 					}
 				}
+				overlay_update(output, false);
 			}
 		}
 	} else if(wlr_box_empty(&output->layout_box)) {
@@ -529,90 +638,67 @@ empty_output_config(void) {
 	cfg->priority = -1;
 	cfg->scale = -1;
 	cfg->angle = -1;
+	cfg->max_render_time = -1;
 
 	return cfg;
 }
 
-/* cfg1 has precedence over cfg2 */
-struct cg_output_config *
-merge_output_configs(struct cg_output_config *cfg1,
-                     struct cg_output_config *cfg2) {
-	struct cg_output_config *out_cfg = empty_output_config();
-	if(cfg1->status == out_cfg->status) {
-		out_cfg->status = cfg2->status;
-	} else {
-		out_cfg->status = cfg1->status;
+/* Merges update into config in place, the options set in update take
+ * precedence */
+void
+output_config_merge(struct cg_output_config *config,
+                    const struct cg_output_config *update) {
+	if(update->status != OUTPUT_DEFAULT) {
+		config->status = update->status;
 	}
-	if(cfg1->role == out_cfg->role) {
-		out_cfg->role = cfg2->role;
-	} else {
-		out_cfg->role = cfg1->role;
+	if(update->role != OUTPUT_ROLE_DEFAULT) {
+		config->role = update->role;
 	}
-	if(cfg1->pos.x == out_cfg->pos.x) {
-		out_cfg->pos.x = cfg2->pos.x;
-		out_cfg->pos.y = cfg2->pos.y;
-		out_cfg->pos.width = cfg2->pos.width;
-		out_cfg->pos.height = cfg2->pos.height;
-	} else {
-		out_cfg->pos.x = cfg1->pos.x;
-		out_cfg->pos.y = cfg1->pos.y;
-		out_cfg->pos.width = cfg1->pos.width;
-		out_cfg->pos.height = cfg1->pos.height;
-	}
-	if(cfg1->output_name == NULL) {
-		if(cfg2->output_name == NULL) {
-			out_cfg->output_name = NULL;
-		} else {
-			out_cfg->output_name = strdup(cfg2->output_name);
-		}
-	} else {
-		out_cfg->output_name = strdup(cfg1->output_name);
+	if(update->pos.x != -1) {
+		config->pos = update->pos;
 	}
-	if(cfg1->refresh_rate == out_cfg->refresh_rate) {
-		out_cfg->refresh_rate = cfg2->refresh_rate;
-	} else {
-		out_cfg->refresh_rate = cfg1->refresh_rate;
+	if(update->refresh_rate != 0) {
+		config->refresh_rate = update->refresh_rate;
 	}
-	if(cfg1->priority == out_cfg->priority) {
-		out_cfg->priority = cfg2->priority;
-	} else {
-		out_cfg->priority = cfg1->priority;
+	if(update->priority != -1) {
+		config->priority = update->priority;
 	}
-	if(cfg1->scale == out_cfg->scale) {
-		out_cfg->scale = cfg2->scale;
-	} else {
-		out_cfg->scale = cfg1->scale;
+	if(update->scale != -1) {
+		config->scale = update->scale;
 	}
-	if(cfg1->angle == out_cfg->angle) {
-		out_cfg->angle = cfg2->angle;
-	} else {
-		out_cfg->angle = cfg1->angle;
+	if(update->angle != -1) {
+		config->angle = update->angle;
+	}
+	if(update->max_render_time != -1) {
+		config->max_render_time = update->max_render_time;
 	}
-	return out_cfg;
 }
 
-void
-output_configure(struct cg_server *server, struct cg_output *output) {
-	struct cg_output_config *tot_config = empty_output_config();
+/* Returns the effective configuration of the output called name. There is
+ * at most one per name, as "output" commands are merged into it. */
+struct cg_output_config *
+output_config_find(struct cg_server *server, const char *name) {
 	struct cg_output_config *config;
 	wl_list_for_each(config, &server->output_config, link) {
-		if(strcmp(config->output_name, output->name) == 0) {
-			if(tot_config == NULL) {
-				return;
-			}
-			struct cg_output_config *prev_config = tot_config;
-			tot_config = merge_output_configs(config, tot_config);
-			if(prev_config->output_name != NULL) {
-				free(prev_config->output_name);
-			}
-			free(prev_config);
+		if(strcmp(config->output_name, name) == 0) {
+			return config;
 		}
 	}
-	if(tot_config != NULL) {
-		output_apply_config(server, output, tot_config);
+	return NULL;
+}
+
+void
+output_configure(struct cg_server *server, struct cg_output *output) {
+	struct cg_output_config *config = output_config_find(server, output->name);
+	if(config != NULL) {
+		output_apply_config(server, output, config);
+		return;
+	}
+	config = empty_output_config();
+	if(config != NULL) {
+		output_apply_config(server, output, config);
+		free(config);
 	}
-	free(tot_config->output_name);
-	free(tot_config);
 }
 
 static void
@@ -634,6 +720,9 @@ handle_output_commit(struct wl_listener *listener, void *data) {
 				view_maximize(view, view->tile);
 			}
 		}
+		/* Overlays are drawn for the scale and anchored to the size of
+		 * the output */
+		overlay_update(output, false);
 	}
 }
 
@@ -718,6 +807,7 @@ handle_new_output(struct wl_listener *listener, void *data) {
 
 	output->wlr_output = wlr_output;
 	output->destroyed = false;
+	frame_stats_init(&output->frame_stats);
 
 	// Store reference to cg_output in wlr_output for layer shell access
 	wlr_output->data = output;
@@ -744,8 +834,11 @@ handle_new_output(struct wl_listener *listener, void *data) {
 		output->workspaces = NULL;
 
 		wl_list_init(&output->messages);
+		wl_list_init(&output->overlays);
 
-		if(!wlr_xcursor_manager_load(server->seat->xcursor_manager,
+		/* With --defer-init, the first deferred step loads the themes */
+		if((!server->defer_init || server->deferred_init_step > 0) &&
+		   !wlr_xcursor_manager_load(server->seat->xcursor_manager,
 		                             wlr_output->scale)) {
 			wlr_log(WLR_ERROR,
 			        "Cannot load XCursor theme for output '%s' with scale %f",
@@ -809,8 +902,7 @@ handle_new_output(struct wl_listener *listener, void *data) {
 	}
 
 	if(server->renderer) {
-		wlr_cursor_set_xcursor(server->seat->cursor,
-		                       server->seat->xcursor_manager, DEFAULT_XCURSOR);
+		seat_set_xcursor(server->seat, DEFAULT_XCURSOR);
 	}
 	wlr_cursor_warp(server->seat->cursor, NULL, 0, 0);
 
@@ -819,6 +911,8 @@ handle_new_output(struct wl_listener *listener, void *data) {
 	wl_signal_add(&wlr_output->events.destroy, &output->destroy);
 	output->frame.notify = handle_output_frame;
 	wl_signal_add(&wlr_output->events.frame, &output->frame);
+	output->present.notify = handle_output_present;
+	wl_signal_add(&wlr_output->events.present, &output->present);
 	output->commit.notify = handle_output_commit;
 	wl_signal_add(&wlr_output->events.commit, &output->commit);
 
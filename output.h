@@ -7,11 +7,19 @@
 #include <wayland-server-core.h>
 #include <wlr/util/box.h>
 
+#include "frame_stats.h"
+#include "message.h"
+
 struct cg_server;
 struct cg_view;
 struct wlr_output;
 struct wlr_surface;
 
+/* Estimate the render time from the commit durations of the last frames */
+#define CG_MAX_RENDER_TIME_AUTO -2
+/* Safety margin added to the estimated render time */
+#define CG_RENDER_TIME_SLACK_NS 1000000
+
 enum output_role {
 	OUTPUT_ROLE_PERIPHERAL,
 	OUTPUT_ROLE_PERMANENT,
@@ -27,8 +35,15 @@ struct cg_output {
 	struct wl_listener commit;
 	struct wl_listener destroy;
 	struct wl_listener frame;
+	struct wl_listener present;
 	struct cg_workspace **workspaces;
 	struct wl_list messages;
+	struct wl_list overlays; // cg_overlay::link
+	struct cg_indicator indicators[CG_INDICATOR_COUNT];
+	struct cg_frame_stats frame_stats;
+	uint64_t frame_ns;   // Time of the most recent frame event
+	int max_render_time; // in ms, 0 is "off" or CG_MAX_RENDER_TIME_AUTO
+	struct wl_event_source *render_timer;
 	struct wlr_box layout_box;
 	int curr_workspace;
 	int priority;
@@ -62,6 +77,7 @@ struct cg_output_config {
 	float scale;
 	int priority;
 	int angle;           // enum wl_output_transform, -1 signifies "unspecified"
+	int max_render_time; // in ms, 0 is "off", -1 signifies "unspecified"
 	struct wl_list link; // cg_server::output_config
 };
 
@@ -76,6 +92,11 @@ handle_new_output(struct wl_listener *listener, void *data);
 void
 output_configure(struct cg_server *server, struct cg_output *output);
 void
+output_config_merge(struct cg_output_config *config,
+                    const struct cg_output_config *update);
+struct cg_output_config *
+output_config_find(struct cg_server *server, const char *name);
+void
 output_apply_config(struct cg_server *server, struct cg_output *output,
                     struct cg_output_config *cfg);
 void
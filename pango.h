@@ -4,6 +4,11 @@
 #ifndef _SWAY_PANGO_H
 #define _SWAY_PANGO_H
 #include <cairo/cairo.h>
+#include <pango/pangocairo.h>
+
+PangoLayout *
+get_pango_layout(cairo_t *cairo, const char *font, const char *text,
+                 double scale);
 
 void
 get_text_size(cairo_t *cairo, const char *font, int *width, int *height,
@@ -6,9 +6,11 @@
 #include <float.h>
 #include <libinput.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wlr/util/log.h>
 
+#include "chord.h"
 #include "input_manager.h"
 #include "keybinding.h"
 #include "message.h"
@@ -429,6 +431,82 @@ parse_definekey(struct cg_server *server, char **saveptr, char **errstr,
 	return keybinding;
 }
 
+/* Returns true if the key definition following the first skip words of str
+ * is a chord, i.e. several comma-separated keys */
+bool
+key_is_chord(const char *str, int skip) {
+	if(str == NULL) {
+		return false;
+	}
+	for(int i = 0; i <= skip; ++i) {
+		str += strspn(str, " ");
+		if(i < skip) {
+			str += strcspn(str, " ");
+		}
+	}
+	size_t len = strcspn(str, " ");
+	const char *comma = strchr(str, ',');
+	return comma != NULL && comma < str + len;
+}
+
+/* Parses "[<mode>] <key>,<key>[,...] <command>", the mode is only read if
+ * mode is -1 */
+struct cg_chord_config *
+parse_chord(struct cg_server *server, int mode, char **saveptr, char **errstr,
+            int nesting_level) {
+	if(mode == -1) {
+		char *mode_str = strtok_r(NULL, " ", saveptr);
+		if(mode_str == NULL) {
+			*errstr =
+			    log_error("Too few arguments to \"definekey\". Expected mode");
+			return NULL;
+		}
+		mode = get_mode_index_from_name(server->modes, mode_str);
+		if(mode == -1) {
+			*errstr = log_error("Unknown mode \"%s\"", mode_str);
+			return NULL;
+		}
+	}
+	struct cg_chord_config *cfg = calloc(1, sizeof(struct cg_chord_config));
+	struct keybinding *kb = malloc(sizeof(struct keybinding));
+	if(cfg == NULL || kb == NULL) {
+		*errstr = log_error("Failed to allocate memory for chord");
+		goto error;
+	}
+	cfg->mode = mode;
+	char *keys = strtok_r(NULL, " ", saveptr);
+	char *keys_saveptr;
+	for(char *key = strtok_r(keys, ",", &keys_saveptr); key != NULL;
+	    key = strtok_r(NULL, ",", &keys_saveptr)) {
+		if(cfg->nkeys == CG_CHORD_MAX_KEYS) {
+			*errstr = log_error("Chords may consist of at most %d keys",
+			                    CG_CHORD_MAX_KEYS);
+			goto error;
+		}
+		if(parse_key(kb, key, errstr) != 0) {
+			goto error;
+		}
+		cfg->keys[cfg->nkeys].modifiers = kb->modifiers;
+		cfg->keys[cfg->nkeys].key = kb->key;
+		++cfg->nkeys;
+	}
+	if(cfg->nkeys < 2) {
+		*errstr = log_error("Expected at least two keys in chord");
+		goto error;
+	}
+	kb->mode = mode;
+	if(parse_command(server, kb, *saveptr, errstr, nesting_level + 1) != 0) {
+		goto error;
+	}
+	cfg->kb = kb;
+	return cfg;
+
+error:
+	free(kb);
+	free(cfg);
+	return NULL;
+}
+
 int
 parse_background(float *color, char **saveptr, char **errstr) {
 	/* Read rgb numbers */
@@ -540,6 +618,8 @@ parse_output_config_keyword(char *key_str, enum output_status *status) {
 		*status = OUTPUT_DEFAULT;
 	} else if(strcmp(key_str, "scale") == 0) {
 		*status = OUTPUT_DEFAULT;
+	} else if(strcmp(key_str, "max_render_time") == 0) {
+		*status = OUTPUT_DEFAULT;
 	} else if(strcmp(key_str, "enable") == 0) {
 		*status = OUTPUT_ENABLE;
 	} else if(strcmp(key_str, "permanent") == 0) {
@@ -569,6 +649,7 @@ parse_output_config(char **saveptr, char **errstr) {
 	cfg->priority = -1;
 	cfg->scale = -1;
 	cfg->angle = -1;
+	cfg->max_render_time = -1;
 	cfg->role = OUTPUT_ROLE_DEFAULT;
 	char *name = strtok_r(NULL, " ", saveptr);
 	if(name == NULL) {
@@ -627,6 +708,28 @@ parse_output_config(char **saveptr, char **errstr) {
 		return cfg;
 	}
 
+	if(strcmp(key_str, "max_render_time") == 0) {
+		char *time_str = strtok_r(NULL, " ", saveptr);
+		if(time_str != NULL && strcmp(time_str, "off") == 0) {
+			cfg->max_render_time = 0;
+		} else if(time_str != NULL && strcmp(time_str, "auto") == 0) {
+			cfg->max_render_time = CG_MAX_RENDER_TIME_AUTO;
+		} else {
+			long time = time_str == NULL ? 0 : strtol(time_str, NULL, 10);
+			if(time < 1 || time > 1000) {
+				*errstr = log_error(
+				    "Error parsing max_render_time of output configuration "
+				    "for output %s, expected \"off\", \"auto\" or a number "
+				    "of milliseconds",
+				    name);
+				goto error;
+			}
+			cfg->max_render_time = time;
+		}
+		cfg->output_name = strdup(name);
+		return cfg;
+	}
+
 	if(strcmp(key_str, "peripheral") == 0) {
 		cfg->output_name = strdup(name);
 		cfg->role = OUTPUT_ROLE_PERIPHERAL;
@@ -706,6 +809,22 @@ error:
 	return NULL;
 }
 
+enum cg_message_anchor
+parse_anchor(const char *anchor) {
+	char *anchors[] = {"top_left",    "top_center",    "top_right",
+	                   "bottom_left", "bottom_center", "bottom_right",
+	                   "center"};
+	if(anchor == NULL) {
+		return CG_MESSAGE_NOPT;
+	}
+	for(int i = 0; i < 7; ++i) {
+		if(strcmp(anchor, anchors[i]) == 0) {
+			return i;
+		}
+	}
+	return CG_MESSAGE_NOPT;
+}
+
 struct cg_message_config *
 parse_message_config(char **saveptr, char **errstr) {
 	struct cg_message_config *cfg = calloc(1, sizeof(struct cg_message_config));
@@ -721,6 +840,7 @@ parse_message_config(char **saveptr, char **errstr) {
 	cfg->font = NULL;
 	cfg->anchor = CG_MESSAGE_NOPT;
 	cfg->enabled = -1;
+	cfg->focus_indicator = -1;
 
 	char *setting = strtok_r(NULL, " ", saveptr);
 	if(setting == NULL) {
@@ -765,15 +885,7 @@ parse_message_config(char **saveptr, char **errstr) {
 			}
 		}
 	} else if(strcmp(setting, "anchor") == 0) {
-		char *anchors[] = {"top_left",    "top_center",    "top_right",
-		                   "bottom_left", "bottom_center", "bottom_right",
-		                   "center"};
-		for(int i = 0; i < 7; ++i) {
-			if(strcmp(*saveptr, anchors[i]) == 0) {
-				cfg->anchor = i;
-				break;
-			}
-		}
+		cfg->anchor = parse_anchor(*saveptr);
 		if(cfg->anchor == CG_MESSAGE_NOPT) {
 			*errstr =
 			    log_error("Error parsing command \"configure_message anchor\", "
@@ -784,6 +896,18 @@ parse_message_config(char **saveptr, char **errstr) {
 		cfg->enabled = 1;
 	} else if(strcmp(setting, "disable") == 0) {
 		cfg->enabled = 0;
+	} else if(strcmp(setting, "focus_indicator") == 0) {
+		char *value = strtok_r(NULL, " ", saveptr);
+		if(value != NULL && strcmp(value, "enable") == 0) {
+			cfg->focus_indicator = 1;
+		} else if(value != NULL && strcmp(value, "disable") == 0) {
+			cfg->focus_indicator = 0;
+		} else {
+			*errstr = log_error("Error parsing command \"configure_message "
+			                    "focus_indicator\", expected \"enable\" or "
+			                    "\"disable\"");
+			goto error;
+		}
 	} else {
 		*errstr = log_error("Invalid option to command \"configure_message\"");
 		goto error;
@@ -799,6 +923,178 @@ error:
 	return NULL;
 }
 
+struct cg_overlay_config *
+parse_overlay_config(char **saveptr, char **errstr) {
+	struct cg_overlay_config *cfg = calloc(1, sizeof(struct cg_overlay_config));
+	if(cfg == NULL) {
+		*errstr = log_error("Failed to allocate memory for overlay command");
+		goto error;
+	}
+
+	char *action = strtok_r(NULL, " ", saveptr);
+	if(action == NULL) {
+		*errstr = log_error("Expected \"set\", \"clock\" or \"remove\" "
+		                    "after \"overlay\", got nothing");
+		goto error;
+	}
+	if(strcmp(action, "set") == 0) {
+		cfg->action = CG_OVERLAY_SET;
+	} else if(strcmp(action, "clock") == 0) {
+		cfg->action = CG_OVERLAY_CLOCK;
+	} else if(strcmp(action, "remove") == 0) {
+		cfg->action = CG_OVERLAY_REMOVE;
+	} else {
+		*errstr = log_error("Invalid option \"%s\" to command \"overlay\"",
+		                    action);
+		goto error;
+	}
+
+	char *name = strtok_r(NULL, " ", saveptr);
+	if(name == NULL) {
+		*errstr = log_error("Expected name of overlay, got nothing");
+		goto error;
+	}
+	cfg->name = strdup(name);
+	if(cfg->name == NULL) {
+		*errstr = log_error("Failed to allocate memory for overlay name");
+		goto error;
+	}
+	if(cfg->action == CG_OVERLAY_REMOVE) {
+		return cfg;
+	}
+
+	char *anchor = strtok_r(NULL, " ", saveptr);
+	cfg->anchor = parse_anchor(anchor);
+	if(cfg->anchor == CG_MESSAGE_NOPT) {
+		*errstr = log_error("Error parsing command \"overlay\", expected a "
+		                    "valid anchor for overlay \"%s\"",
+		                    name);
+		goto error;
+	}
+
+	if(*saveptr == NULL || **saveptr == '\0') {
+		if(cfg->action == CG_OVERLAY_SET) {
+			*errstr = log_error("Not enough paramaters to \"overlay set\". "
+			                    "Expected string to display.");
+			goto error;
+		}
+		cfg->text = strdup("%H:%M:%S");
+	} else {
+		cfg->text = strdup(*saveptr);
+	}
+	if(cfg->text == NULL) {
+		*errstr = log_error("Failed to allocate memory for overlay text");
+		goto error;
+	}
+	return cfg;
+
+error:
+	if(cfg != NULL) {
+		free(cfg->name);
+		free(cfg);
+	}
+	wlr_log(WLR_ERROR,
+	        "Overlay commands must be of the form 'overlay set <name> <anchor> "
+	        "<text>', 'overlay clock <name> <anchor> [<format>]' or 'overlay "
+	        "remove <name>'");
+	return NULL;
+}
+
+/* All commands, sorted by name for command_from_name */
+#define FOREACH_COMMAND(COMMAND)                                               \
+	COMMAND(COMMAND_ABORT, abort)                                              \
+	COMMAND(COMMAND_BACKGROUND, background)                                    \
+	COMMAND(COMMAND_BIND, bind)                                                \
+	COMMAND(COMMAND_CHORD_TIMEOUT, chord_timeout)                              \
+	COMMAND(COMMAND_CLOSE, close)                                              \
+	COMMAND(COMMAND_CONFIGURE_MESSAGE, configure_message)                      \
+	COMMAND(COMMAND_CURSOR, cursor)                                            \
+	COMMAND(COMMAND_CUSTOM_EVENT, custom_event)                                \
+	COMMAND(COMMAND_DEFINEKEY, definekey)                                      \
+	COMMAND(COMMAND_DEFINEMODE, definemode)                                    \
+	COMMAND(COMMAND_DUMP, dump)                                                \
+	COMMAND(COMMAND_ESCAPE, escape)                                            \
+	COMMAND(COMMAND_EXCHANGE, exchange)                                        \
+	COMMAND(COMMAND_EXCHANGEDOWN, exchangedown)                                \
+	COMMAND(COMMAND_EXCHANGELEFT, exchangeleft)                                \
+	COMMAND(COMMAND_EXCHANGERIGHT, exchangeright)                              \
+	COMMAND(COMMAND_EXCHANGEUP, exchangeup)                                    \
+	COMMAND(COMMAND_EXEC, exec)                                                \
+	COMMAND(COMMAND_FOCUS, focus)                                              \
+	COMMAND(COMMAND_FOCUSDOWN, focusdown)                                      \
+	COMMAND(COMMAND_FOCUSLEFT, focusleft)                                      \
+	COMMAND(COMMAND_FOCUSPREV, focusprev)                                      \
+	COMMAND(COMMAND_FOCUSRIGHT, focusright)                                    \
+	COMMAND(COMMAND_FOCUSUP, focusup)                                          \
+	COMMAND(COMMAND_HSPLIT, hsplit)                                            \
+	COMMAND(COMMAND_IDLE_INTERVAL, idle_interval)                              \
+	COMMAND(COMMAND_INPUT, input)                                              \
+	COMMAND(COMMAND_MERGEDOWN, mergedown)                                      \
+	COMMAND(COMMAND_MERGELEFT, mergeleft)                                      \
+	COMMAND(COMMAND_MERGERIGHT, mergeright)                                    \
+	COMMAND(COMMAND_MERGEUP, mergeup)                                          \
+	COMMAND(COMMAND_MESSAGE, message)                                          \
+	COMMAND(COMMAND_MODE, mode)                                                \
+	COMMAND(COMMAND_MOVETONEXTSCREEN, movetonextscreen)                        \
+	COMMAND(COMMAND_MOVETOPREVSCREEN, movetoprevscreen)                        \
+	COMMAND(COMMAND_MOVETOSCREEN, movetoscreen)                                \
+	COMMAND(COMMAND_MOVETOTILE, movetotile)                                    \
+	COMMAND(COMMAND_MOVETOWORKSPACE, movetoworkspace)                          \
+	COMMAND(COMMAND_MOVEVIEWTOSCREEN, moveviewtoscreen)                        \
+	COMMAND(COMMAND_MOVEVIEWTOTILE, moveviewtotile)                            \
+	COMMAND(COMMAND_MOVEVIEWTOWORKSPACE, moveviewtoworkspace)                  \
+	COMMAND(COMMAND_NEXT, next)                                                \
+	COMMAND(COMMAND_NEXTSCREEN, nextscreen)                                    \
+	COMMAND(COMMAND_ONLY, only)                                                \
+	COMMAND(COMMAND_OUTPUT, output)                                            \
+	COMMAND(COMMAND_OVERLAY, overlay)                                          \
+	COMMAND(COMMAND_PREV, prev)                                                \
+	COMMAND(COMMAND_PREVSCREEN, prevscreen)                                    \
+	COMMAND(COMMAND_QUIT, quit)                                                \
+	COMMAND(COMMAND_RECORD, record)                                            \
+	COMMAND(COMMAND_RELOAD, reload)                                            \
+	COMMAND(COMMAND_REPLAY, replay)                                            \
+	COMMAND(COMMAND_RESIZEDOWN, resizedown)                                    \
+	COMMAND(COMMAND_RESIZELEFT, resizeleft)                                    \
+	COMMAND(COMMAND_RESIZERIGHT, resizeright)                                  \
+	COMMAND(COMMAND_RESIZEUP, resizeup)                                        \
+	COMMAND(COMMAND_SCREEN, screen)                                            \
+	COMMAND(COMMAND_SETMODE, setmode)                                          \
+	COMMAND(COMMAND_SETMODECURSOR, setmodecursor)                              \
+	COMMAND(COMMAND_SHOW_INFO, show_info)                                      \
+	COMMAND(COMMAND_STATS, stats)                                              \
+	COMMAND(COMMAND_SWITCHVT, switchvt)                                        \
+	COMMAND(COMMAND_TIME, time)                                                \
+	COMMAND(COMMAND_VSPLIT, vsplit)                                            \
+	COMMAND(COMMAND_WORKSPACE, workspace)                                      \
+	COMMAND(COMMAND_WORKSPACES, workspaces)
+
+#define GENERATE_COMMAND_ENUM(ENUM, NAME) ENUM,
+#define GENERATE_COMMAND_STRING(ENUM, NAME) #NAME,
+
+enum cg_command { FOREACH_COMMAND(GENERATE_COMMAND_ENUM) COMMAND_UNKNOWN };
+
+static const char *command_names[] = {
+    FOREACH_COMMAND(GENERATE_COMMAND_STRING)};
+
+static int
+compare_command_name(const void *name, const void *entry) {
+	return strcmp(name, *(const char *const *)entry);
+}
+
+/* Looks up the command with the given name by binary search, returns
+ * COMMAND_UNKNOWN if there is none */
+static enum cg_command
+command_from_name(const char *name) {
+	const char **entry = bsearch(
+	    name, command_names, sizeof(command_names) / sizeof(command_names[0]),
+	    sizeof(command_names[0]), compare_command_name);
+	if(entry == NULL) {
+		return COMMAND_UNKNOWN;
+	}
+	return entry - command_names;
+}
+
 int
 parse_command(struct cg_server *server, struct keybinding *keybinding,
               char *saveptr, char **errstr, int nesting_level) {
@@ -813,7 +1109,8 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		return -1;
 	}
 	keybinding->data = (union keybinding_params){.c = NULL};
-	if(strcmp(action, "vsplit") == 0) {
+	switch(command_from_name(action)) {
+	case COMMAND_VSPLIT: {
 		keybinding->action = KEYBINDING_SPLIT_VERTICAL;
 		char *percentage_string = strtok_r(NULL, " ", &saveptr);
 		if(percentage_string == NULL) {
@@ -831,8 +1128,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.f = percentage;
 		}
-
-	} else if(strcmp(action, "hsplit") == 0) {
+		break;
+	}
+	case COMMAND_HSPLIT: {
 		keybinding->action = KEYBINDING_SPLIT_HORIZONTAL;
 		char *percentage_string = strtok_r(NULL, " ", &saveptr);
 		if(percentage_string == NULL) {
@@ -850,15 +1148,62 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.f = percentage;
 		}
-	} else if(strcmp(action, "quit") == 0) {
+		break;
+	}
+	case COMMAND_QUIT:
 		keybinding->action = KEYBINDING_QUIT;
-	} else if(strcmp(action, "dump") == 0) {
+		break;
+	case COMMAND_DUMP:
 		keybinding->action = KEYBINDING_DUMP;
-	} else if(strcmp(action, "show_info") == 0) {
+		break;
+	case COMMAND_STATS: {
+		keybinding->action = KEYBINDING_STATS;
+		char *kind = strtok_r(NULL, " ", &saveptr);
+		if(kind != NULL && strcmp(kind, "output") == 0) {
+			keybinding->data.us[0] = CG_STATS_OUTPUT;
+		} else if(kind != NULL && strcmp(kind, "stream") == 0) {
+			keybinding->data.us[0] = CG_STATS_STREAM;
+		} else if(kind != NULL && strcmp(kind, "input") == 0) {
+			keybinding->data.us[0] = CG_STATS_INPUT;
+			keybinding->data.us[1] = 0;
+			return 0;
+		} else if(kind != NULL && strcmp(kind, "launch") == 0) {
+			keybinding->data.us[0] = CG_STATS_LAUNCH;
+			keybinding->data.us[1] = 0;
+			return 0;
+		} else {
+			*errstr = log_error("Expected \"output\", \"stream\", \"input\" "
+			                    "or \"launch\" after \"stats\".");
+			return -1;
+		}
+		char *num_str = strtok_r(NULL, " ", &saveptr);
+		if(num_str == NULL) {
+			*errstr = log_error("Expected argument for \"stats %s\", got none.",
+			                    kind);
+			return -1;
+		}
+		long num = strtol(num_str, NULL, 10);
+		long min = keybinding->data.us[0] == CG_STATS_OUTPUT ? 1 : 0;
+		/* The interval of "stats stream" is passed to the timer in
+		 * milliseconds */
+		long max = keybinding->data.us[0] == CG_STATS_STREAM ? INT_MAX / 1000
+		                                                     : INT_MAX;
+		if(num < min || num > max) {
+			*errstr = log_error("Argument of \"stats %s\" must be an integer "
+			                    "number between %ld and %ld. Got %ld",
+			                    kind, min, max, num);
+			return -1;
+		}
+		keybinding->data.us[1] = num;
+		break;
+	}
+	case COMMAND_SHOW_INFO:
 		keybinding->action = KEYBINDING_SHOW_INFO;
-	} else if(strcmp(action, "close") == 0) {
+		break;
+	case COMMAND_CLOSE:
 		keybinding->action = KEYBINDING_CLOSE_VIEW;
-	} else if(strcmp(action, "focus") == 0) {
+		break;
+	case COMMAND_FOCUS: {
 		keybinding->action = KEYBINDING_CYCLE_TILES;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 0;
@@ -873,11 +1218,14 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.us[1] = tile_id;
 		}
-	} else if(strcmp(action, "focusprev") == 0) {
+		break;
+	}
+	case COMMAND_FOCUSPREV:
 		keybinding->action = KEYBINDING_CYCLE_TILES;
 		keybinding->data.us[0] = 1;
 		keybinding->data.us[1] = 0;
-	} else if(strcmp(action, "next") == 0) {
+		break;
+	case COMMAND_NEXT: {
 		keybinding->action = KEYBINDING_CYCLE_VIEWS;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 0;
@@ -892,11 +1240,14 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.us[1] = view_id;
 		}
-	} else if(strcmp(action, "prev") == 0) {
+		break;
+	}
+	case COMMAND_PREV:
 		keybinding->action = KEYBINDING_CYCLE_VIEWS;
 		keybinding->data.us[0] = 1;
 		keybinding->data.us[1] = 0;
-	} else if(strcmp(action, "only") == 0) {
+		break;
+	case COMMAND_ONLY: {
 		keybinding->action = KEYBINDING_LAYOUT_FULLSCREEN;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 0;
@@ -926,9 +1277,12 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.us[1] = workspace - 1;
 		}
-	} else if(strcmp(action, "abort") == 0) {
+		break;
+	}
+	case COMMAND_ABORT:
 		keybinding->action = KEYBINDING_NOOP;
-	} else if(strcmp(action, "message") == 0) {
+		break;
+	case COMMAND_MESSAGE:
 		keybinding->action = KEYBINDING_DISPLAY_MESSAGE;
 		if(saveptr == NULL) {
 			*errstr =
@@ -937,7 +1291,15 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.c = strdup(saveptr);
-	} else if(strcmp(action, "custom_event") == 0) {
+		break;
+	case COMMAND_OVERLAY:
+		keybinding->action = KEYBINDING_OVERLAY;
+		keybinding->data.ov_cfg = parse_overlay_config(&saveptr, errstr);
+		if(keybinding->data.ov_cfg == NULL) {
+			return -1;
+		}
+		break;
+	case COMMAND_CUSTOM_EVENT:
 		keybinding->action = KEYBINDING_SEND_CUSTOM_EVENT;
 		if(saveptr == NULL) {
 			*errstr =
@@ -946,15 +1308,19 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.c = strdup(saveptr);
-	} else if(strcmp(action, "time") == 0) {
+		break;
+	case COMMAND_TIME:
 		keybinding->action = KEYBINDING_SHOW_TIME;
-	} else if(strcmp(action, "nextscreen") == 0) {
+		break;
+	case COMMAND_NEXTSCREEN:
 		keybinding->action = KEYBINDING_CYCLE_OUTPUT;
 		keybinding->data.b = false;
-	} else if(strcmp(action, "prevscreen") == 0) {
+		break;
+	case COMMAND_PREVSCREEN:
 		keybinding->action = KEYBINDING_CYCLE_OUTPUT;
 		keybinding->data.b = true;
-	} else if(strcmp(action, "exec") == 0) {
+		break;
+	case COMMAND_EXEC:
 		keybinding->action = KEYBINDING_RUN_COMMAND;
 		if(saveptr == NULL) {
 			*errstr = log_error("Not enough paramaters to \"exec\". Expected "
@@ -962,7 +1328,8 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.c = strdup(saveptr);
-	} else if(strcmp(action, "resizeleft") == 0) {
+		break;
+	case COMMAND_RESIZELEFT: {
 		keybinding->action = KEYBINDING_RESIZE_TILE_HORIZONTAL;
 		keybinding->data.is[0] = -10;
 		keybinding->data.is[1] = 0;
@@ -989,7 +1356,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.is[1] = tile_id;
 		}
-	} else if(strcmp(action, "resizeright") == 0) {
+		break;
+	}
+	case COMMAND_RESIZERIGHT: {
 		keybinding->action = KEYBINDING_RESIZE_TILE_HORIZONTAL;
 		keybinding->data.is[0] = 10;
 		keybinding->data.is[1] = 0;
@@ -1016,7 +1385,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.is[1] = tile_id;
 		}
-	} else if(strcmp(action, "resizedown") == 0) {
+		break;
+	}
+	case COMMAND_RESIZEDOWN: {
 		keybinding->action = KEYBINDING_RESIZE_TILE_VERTICAL;
 		keybinding->data.is[0] = 10;
 		keybinding->data.is[1] = 0;
@@ -1043,7 +1414,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.is[1] = tile_id;
 		}
-	} else if(strcmp(action, "resizeup") == 0) {
+		break;
+	}
+	case COMMAND_RESIZEUP: {
 		keybinding->action = KEYBINDING_RESIZE_TILE_VERTICAL;
 		keybinding->data.is[0] = -10;
 		keybinding->data.is[1] = 0;
@@ -1070,7 +1443,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.is[1] = tile_id;
 		}
-	} else if(strcmp(action, "screen") == 0) {
+		break;
+	}
+	case COMMAND_SCREEN: {
 		keybinding->action = KEYBINDING_SWITCH_OUTPUT;
 		char *noutp_str = strtok_r(NULL, " ", &saveptr);
 		if(noutp_str == NULL) {
@@ -1087,7 +1462,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.u = outp;
-	} else if(strcmp(action, "workspace") == 0) {
+		break;
+	}
+	case COMMAND_WORKSPACE: {
 		keybinding->action = KEYBINDING_SWITCH_WORKSPACE;
 		char *nws_str = strtok_r(NULL, " ", &saveptr);
 		if(nws_str == NULL) {
@@ -1104,7 +1481,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.u = ws - 1;
-	} else if(strcmp(action, "moveviewtoscreen") == 0) {
+		break;
+	}
+	case COMMAND_MOVEVIEWTOSCREEN: {
 		keybinding->action = KEYBINDING_MOVE_VIEW_TO_OUTPUT;
 		char *view_id_str = strtok_r(NULL, " ", &saveptr);
 		if(view_id_str == NULL) {
@@ -1152,7 +1531,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		keybinding->data.us[0] = view_id;
 		keybinding->data.us[1] = outp;
 		keybinding->data.us[2] = follow;
-	} else if(strcmp(action, "moveviewtoworkspace") == 0) {
+		break;
+	}
+	case COMMAND_MOVEVIEWTOWORKSPACE: {
 		keybinding->action = KEYBINDING_MOVE_VIEW_TO_WORKSPACE;
 		char *view_id_str = strtok_r(NULL, " ", &saveptr);
 		if(view_id_str == NULL) {
@@ -1199,7 +1580,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		keybinding->data.us[0] = view_id;
 		keybinding->data.us[1] = ws - 1;
 		keybinding->data.us[2] = follow;
-	} else if(strcmp(action, "moveviewtotile") == 0) {
+		break;
+	}
+	case COMMAND_MOVEVIEWTOTILE: {
 		keybinding->action = KEYBINDING_MOVE_VIEW_TO_TILE;
 		char *view_id_str = strtok_r(NULL, " ", &saveptr);
 		if(view_id_str == NULL) {
@@ -1246,7 +1629,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		keybinding->data.us[0] = view_id;
 		keybinding->data.us[1] = tile_id;
 		keybinding->data.us[2] = follow;
-	} else if(strcmp(action, "movetoscreen") == 0) {
+		break;
+	}
+	case COMMAND_MOVETOSCREEN: {
 		keybinding->action = KEYBINDING_MOVE_TO_OUTPUT;
 		char *noutp_str = strtok_r(NULL, " ", &saveptr);
 		if(noutp_str == NULL) {
@@ -1278,7 +1663,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		}
 		keybinding->data.us[0] = outp;
 		keybinding->data.us[1] = follow;
-	} else if(strcmp(action, "movetoworkspace") == 0) {
+		break;
+	}
+	case COMMAND_MOVETOWORKSPACE: {
 		keybinding->action = KEYBINDING_MOVE_TO_WORKSPACE;
 		char *nws_str = strtok_r(NULL, " ", &saveptr);
 		if(nws_str == NULL) {
@@ -1310,7 +1697,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		}
 		keybinding->data.us[0] = ws - 1;
 		keybinding->data.us[1] = follow;
-	} else if(strcmp(action, "movetotile") == 0) {
+		break;
+	}
+	case COMMAND_MOVETOTILE: {
 		keybinding->action = KEYBINDING_MOVE_TO_TILE;
 		char *tile_str = strtok_r(NULL, " ", &saveptr);
 		if(tile_str == NULL) {
@@ -1342,7 +1731,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		}
 		keybinding->data.us[0] = tile;
 		keybinding->data.us[1] = follow;
-	} else if(strcmp(action, "mergeleft") == 0) {
+		break;
+	}
+	case COMMAND_MERGELEFT: {
 		keybinding->action = KEYBINDING_MERGE_LEFT;
 		keybinding->data.u = 0;
 		char *tile_str = strtok_r(NULL, " ", &saveptr);
@@ -1356,7 +1747,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.u = tile_id;
 		}
-	} else if(strcmp(action, "mergeright") == 0) {
+		break;
+	}
+	case COMMAND_MERGERIGHT: {
 		keybinding->action = KEYBINDING_MERGE_RIGHT;
 		keybinding->data.u = 0;
 		char *tile_str = strtok_r(NULL, " ", &saveptr);
@@ -1370,7 +1763,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.u = tile_id;
 		}
-	} else if(strcmp(action, "mergeup") == 0) {
+		break;
+	}
+	case COMMAND_MERGEUP: {
 		keybinding->action = KEYBINDING_MERGE_TOP;
 		keybinding->data.u = 0;
 		char *tile_str = strtok_r(NULL, " ", &saveptr);
@@ -1384,7 +1779,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.u = tile_id;
 		}
-	} else if(strcmp(action, "mergedown") == 0) {
+		break;
+	}
+	case COMMAND_MERGEDOWN: {
 		keybinding->action = KEYBINDING_MERGE_BOTTOM;
 		keybinding->data.u = 0;
 		char *tile_str = strtok_r(NULL, " ", &saveptr);
@@ -1398,7 +1795,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			}
 			keybinding->data.u = tile_id;
 		}
-	} else if(strcmp(action, "exchangeleft") == 0) {
+		break;
+	}
+	case COMMAND_EXCHANGELEFT: {
 		keybinding->action = KEYBINDING_SWAP_LEFT;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 1;
@@ -1429,7 +1828,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 				}
 			}
 		}
-	} else if(strcmp(action, "exchangeright") == 0) {
+		break;
+	}
+	case COMMAND_EXCHANGERIGHT: {
 		keybinding->action = KEYBINDING_SWAP_RIGHT;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 1;
@@ -1460,7 +1861,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 				}
 			}
 		}
-	} else if(strcmp(action, "exchangeup") == 0) {
+		break;
+	}
+	case COMMAND_EXCHANGEUP: {
 		keybinding->action = KEYBINDING_SWAP_TOP;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 1;
@@ -1491,7 +1894,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 				}
 			}
 		}
-	} else if(strcmp(action, "exchangedown") == 0) {
+		break;
+	}
+	case COMMAND_EXCHANGEDOWN: {
 		keybinding->action = KEYBINDING_SWAP_BOTTOM;
 		keybinding->data.us[0] = 0;
 		keybinding->data.us[1] = 1;
@@ -1522,7 +1927,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 				}
 			}
 		}
-	} else if(strcmp(action, "exchange") == 0) {
+		break;
+	}
+	case COMMAND_EXCHANGE: {
 		keybinding->action = KEYBINDING_SWAP;
 		char *tile1_str = strtok_r(NULL, " ", &saveptr);
 		keybinding->data.us[2] = 1;
@@ -1571,21 +1978,29 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 				return -1;
 			}
 		}
-	} else if(strcmp(action, "focusleft") == 0) {
+		break;
+	}
+	case COMMAND_FOCUSLEFT:
 		keybinding->action = KEYBINDING_FOCUS_LEFT;
-	} else if(strcmp(action, "focusright") == 0) {
+		break;
+	case COMMAND_FOCUSRIGHT:
 		keybinding->action = KEYBINDING_FOCUS_RIGHT;
-	} else if(strcmp(action, "focusup") == 0) {
+		break;
+	case COMMAND_FOCUSUP:
 		keybinding->action = KEYBINDING_FOCUS_TOP;
-	} else if(strcmp(action, "focusdown") == 0) {
+		break;
+	case COMMAND_FOCUSDOWN:
 		keybinding->action = KEYBINDING_FOCUS_BOTTOM;
-	} else if(strcmp(action, "movetonextscreen") == 0) {
+		break;
+	case COMMAND_MOVETONEXTSCREEN:
 		keybinding->action = KEYBINDING_MOVE_VIEW_TO_CYCLE_OUTPUT;
 		keybinding->data.b = false;
-	} else if(strcmp(action, "movetoprevscreen") == 0) {
+		break;
+	case COMMAND_MOVETOPREVSCREEN:
 		keybinding->action = KEYBINDING_MOVE_VIEW_TO_CYCLE_OUTPUT;
 		keybinding->data.b = true;
-	} else if(strcmp(action, "switchvt") == 0) {
+		break;
+	case COMMAND_SWITCHVT: {
 		keybinding->action = KEYBINDING_CHANGE_TTY;
 		char *ntty = strtok_r(NULL, " ", &saveptr);
 		if(ntty == NULL) {
@@ -1599,7 +2014,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.u = tty;
-	} else if(strcmp(action, "mode") == 0) {
+		break;
+	}
+	case COMMAND_MODE: {
 		keybinding->action = KEYBINDING_SWITCH_MODE;
 		char *mode = strtok_r(NULL, " ", &saveptr);
 		if(mode == NULL) {
@@ -1612,7 +2029,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.u = (unsigned int)mode_idx;
-	} else if(strcmp(action, "setmode") == 0) {
+		break;
+	}
+	case COMMAND_SETMODE: {
 		keybinding->action = KEYBINDING_SWITCH_DEFAULT_MODE;
 		char *mode = strtok_r(NULL, " ", &saveptr);
 		if(mode == NULL) {
@@ -1627,7 +2046,9 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.u = (unsigned int)mode_idx;
-	} else if(strcmp(action, "setmodecursor") == 0) {
+		break;
+	}
+	case COMMAND_SETMODECURSOR: {
 		keybinding->action = KEYBINDING_SETMODECURSOR;
 		char *mode = strtok_r(NULL, " ", &saveptr);
 		if(mode == NULL) {
@@ -1643,94 +2064,190 @@ parse_command(struct cg_server *server, struct keybinding *keybinding,
 		}
 		keybinding->data.cs[0] = strdup(mode);
 		keybinding->data.cs[1] = strdup(cursor);
-	} else if(strcmp(action, "bind") == 0) {
-		keybinding->action = KEYBINDING_DEFINEKEY;
-		keybinding->data.kb =
-		    parse_bind(server, &saveptr, errstr, nesting_level);
-		if(keybinding->data.kb == NULL) {
-			return -1;
+		break;
+	}
+	case COMMAND_BIND:
+		if(key_is_chord(saveptr, 0)) {
+			keybinding->action = KEYBINDING_DEFINECHORD;
+			keybinding->data.ch =
+			    parse_chord(server, 1, &saveptr, errstr, nesting_level);
+			if(keybinding->data.ch == NULL) {
+				return -1;
+			}
+		} else {
+			keybinding->action = KEYBINDING_DEFINEKEY;
+			keybinding->data.kb =
+			    parse_bind(server, &saveptr, errstr, nesting_level);
+			if(keybinding->data.kb == NULL) {
+				return -1;
+			}
 		}
-	} else if(strcmp(action, "definekey") == 0) {
-		keybinding->action = KEYBINDING_DEFINEKEY;
-		keybinding->data.kb =
-		    parse_definekey(server, &saveptr, errstr, nesting_level);
-		if(keybinding->data.kb == NULL) {
-			return -1;
+		break;
+	case COMMAND_DEFINEKEY:
+		if(key_is_chord(saveptr, 1)) {
+			keybinding->action = KEYBINDING_DEFINECHORD;
+			keybinding->data.ch =
+			    parse_chord(server, -1, &saveptr, errstr, nesting_level);
+			if(keybinding->data.ch == NULL) {
+				return -1;
+			}
+		} else {
+			keybinding->action = KEYBINDING_DEFINEKEY;
+			keybinding->data.kb =
+			    parse_definekey(server, &saveptr, errstr, nesting_level);
+			if(keybinding->data.kb == NULL) {
+				return -1;
+			}
 		}
-	} else if(strcmp(action, "background") == 0) {
+		break;
+	case COMMAND_BACKGROUND:
 		keybinding->action = KEYBINDING_BACKGROUND;
 		if(parse_background(keybinding->data.color, &saveptr, errstr) != 0) {
 			return -1;
 		}
-	} else if(strcmp(action, "escape") == 0) {
+		break;
+	case COMMAND_ESCAPE:
 		keybinding->action = KEYBINDING_DEFINEKEY;
 		keybinding->data.kb = parse_escape(&saveptr, errstr);
 		if(keybinding->data.kb == NULL) {
 			return -1;
 		}
-	} else if(strcmp(action, "cursor") == 0) {
+		break;
+	case COMMAND_CURSOR:
 		keybinding->action = KEYBINDING_CURSOR;
 		keybinding->data.i = parse_cursor(&saveptr, errstr);
 		if(keybinding->data.i < 0) {
 			return -1;
 		}
-	} else if(strcmp(action, "definemode") == 0) {
+		break;
+	case COMMAND_DEFINEMODE:
 		keybinding->action = KEYBINDING_DEFINEMODE;
 		keybinding->data.c = parse_definemode(&saveptr, errstr);
 		if(keybinding->data.c == NULL) {
 			return -1;
 		}
-	} else if(strcmp(action, "workspaces") == 0) {
+		break;
+	case COMMAND_WORKSPACES:
 		keybinding->action = KEYBINDING_WORKSPACES;
 		keybinding->data.i = parse_workspaces(&saveptr, errstr);
 		if(keybinding->data.i < 0) {
 			return -1;
 		}
-	} else if(strcmp(action, "output") == 0) {
+		break;
+	case COMMAND_IDLE_INTERVAL: {
+		keybinding->action = KEYBINDING_IDLE_INTERVAL;
+		char *num_str = strtok_r(NULL, " ", &saveptr);
+		if(num_str == NULL) {
+			*errstr = log_error(
+			    "Expected argument for \"idle_interval\" command, got none.");
+			return -1;
+		}
+		long num = strtol(num_str, NULL, 10);
+		if(num < 0 || num > 60000) {
+			*errstr = log_error("Argument of \"idle_interval\" must be an "
+			                    "integer between 0 and 60000. Got %ld",
+			                    num);
+			return -1;
+		}
+		keybinding->data.u = num;
+		break;
+	}
+	case COMMAND_CHORD_TIMEOUT: {
+		keybinding->action = KEYBINDING_CHORD_TIMEOUT;
+		char *num_str = strtok_r(NULL, " ", &saveptr);
+		if(num_str == NULL) {
+			*errstr = log_error(
+			    "Expected argument for \"chord_timeout\" command, got none.");
+			return -1;
+		}
+		long num = strtol(num_str, NULL, 10);
+		if(num < 0 || num > 60000) {
+			*errstr = log_error("Argument of \"chord_timeout\" must be an "
+			                    "integer between 0 and 60000. Got %ld",
+			                    num);
+			return -1;
+		}
+		keybinding->data.u = num;
+		break;
+	}
+	case COMMAND_RECORD: {
+		if(!server->bs) {
+			*errstr = log_error("\"record\" is only available with --bs.");
+			return -1;
+		}
+		keybinding->action = KEYBINDING_RECORD;
+		char *cmd = strtok_r(NULL, " ", &saveptr);
+		if(cmd != NULL && strcmp(cmd, "stop") == 0) {
+			keybinding->data.c = NULL;
+		} else if(cmd != NULL && strcmp(cmd, "start") == 0 &&
+		          saveptr != NULL && *saveptr != '\0') {
+			keybinding->data.c = strdup(saveptr);
+		} else {
+			*errstr = log_error("Expected \"start <file>\" or \"stop\" after "
+			                    "\"record\".");
+			return -1;
+		}
+		break;
+	}
+	case COMMAND_RELOAD:
+		keybinding->action = KEYBINDING_RELOAD;
+		break;
+	case COMMAND_REPLAY:
+		if(!server->bs) {
+			*errstr = log_error("\"replay\" is only available with --bs.");
+			return -1;
+		}
+		keybinding->action = KEYBINDING_REPLAY;
+		if(saveptr == NULL || *saveptr == '\0') {
+			*errstr = log_error("Expected file for \"replay\", got none.");
+			return -1;
+		}
+		keybinding->data.c = strdup(saveptr);
+		break;
+	case COMMAND_OUTPUT:
 		keybinding->action = KEYBINDING_CONFIGURE_OUTPUT;
 		keybinding->data.o_cfg = parse_output_config(&saveptr, errstr);
 		if(keybinding->data.o_cfg == NULL) {
 			return -1;
 		}
-	} else if(strcmp(action, "input") == 0) {
+		break;
+	case COMMAND_INPUT:
 		keybinding->action = KEYBINDING_CONFIGURE_INPUT;
 		keybinding->data.i_cfg = parse_input_config(&saveptr, errstr);
 		if(keybinding->data.i_cfg == NULL) {
 			return -1;
 		}
-	} else if(strcmp(action, "configure_message") == 0) {
+		break;
+	case COMMAND_CONFIGURE_MESSAGE:
 		keybinding->action = KEYBINDING_CONFIGURE_MESSAGE;
 		keybinding->data.m_cfg = parse_message_config(&saveptr, errstr);
 		if(keybinding->data.m_cfg == NULL) {
 			return -1;
 		}
-	} else {
+		break;
+	default:
 		*errstr = log_error("Error, unsupported action \"%s\".", action);
 		return -1;
 	}
 	return 0;
 }
 
+/* Parses and runs the command in line. The line is tokenized in place, so
+ * its contents are undefined afterwards. */
 int
 parse_rc_line(struct cg_server *server, char *line, char **errstr) {
-	char *saveptr = strdup(line); // Used internally by strtok_r
-
 	struct keybinding *keybinding = malloc(sizeof(struct keybinding));
 	if(keybinding == NULL) {
 		*errstr = log_error(
 		    "Failed to allocate memory for temporary keybinding struct.");
-		free(keybinding);
-		free(saveptr);
 		return -1;
 	}
-	if(parse_command(server, keybinding, saveptr, errstr, 1) != 0) {
+	if(parse_command(server, keybinding, line, errstr, 1) != 0) {
 		wlr_log(WLR_ERROR, "Error parsing command.");
 		free(keybinding);
-		free(saveptr);
 		return -1;
 	}
 	run_action(keybinding->action, server, keybinding->data);
 	keybinding_free(keybinding, false);
-	free(saveptr);
 	return 0;
 }
@@ -8,7 +8,11 @@
 #include <stdio.h>
 
 struct cg_server;
+struct keybinding;
 
+int
+parse_command(struct cg_server *server, struct keybinding *keybinding,
+              char *saveptr, char **errstr, int nesting_level);
 int
 parse_rc_line(struct cg_server *server, char *line, char **errstr);
 char *
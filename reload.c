@@ -0,0 +1,521 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+
+#include "chord.h"
+#include "input_manager.h"
+#include "ipc_server.h"
+#include "keybinding.h"
+#include "message.h"
+#include "output.h"
+#include "parse.h"
+#include "reload.h"
+#include "seat.h"
+#include "server.h"
+#include "util.h"
+
+/* Parts of the configuration which are compared on reload, in the order in
+ * which they are applied. All other commands are only run when the
+ * configuration is loaded at startup. */
+enum cg_config_kind {
+	CG_CONFIG_BINDING,
+	CG_CONFIG_CHORD,
+	CG_CONFIG_OUTPUT,
+	CG_CONFIG_INPUT,
+	CG_CONFIG_MESSAGE,
+	CG_CONFIG_BACKGROUND,
+};
+
+struct cg_config_entry {
+	enum cg_config_kind kind;
+	uint32_t line;
+	const char *text; // Line in the unmodified contents of the file
+	size_t text_len;
+	struct keybinding *kb;
+};
+
+/* The commands of a configuration file, sorted such that the lines
+ * configuring the same binding, output or input device are adjacent */
+struct cg_config_model {
+	struct cg_config_entry *entries;
+	size_t len;
+	size_t cap;
+	/* Modes of "definemode" lines which did not exist yet, see
+	 * config_model_add_mode */
+	char **modes;
+	size_t nmodes;
+};
+
+struct cg_reload_stats {
+	uint32_t bindings;
+	uint32_t outputs;
+	uint32_t inputs;
+	bool chords;
+	bool message;
+	bool background;
+};
+
+static int
+config_kind(enum keybinding_action action) {
+	switch(action) {
+	case KEYBINDING_DEFINEKEY:
+		return CG_CONFIG_BINDING;
+	case KEYBINDING_DEFINECHORD:
+	case KEYBINDING_CHORD_TIMEOUT:
+		return CG_CONFIG_CHORD;
+	case KEYBINDING_CONFIGURE_OUTPUT:
+		return CG_CONFIG_OUTPUT;
+	case KEYBINDING_CONFIGURE_INPUT:
+		return CG_CONFIG_INPUT;
+	case KEYBINDING_CONFIGURE_MESSAGE:
+		return CG_CONFIG_MESSAGE;
+	case KEYBINDING_BACKGROUND:
+		return CG_CONFIG_BACKGROUND;
+	default:
+		return -1;
+	}
+}
+
+/* Whether the command only sets configuration which "reload" compares, such
+ * that running it again from a parsed copy has the same effect */
+bool
+reload_is_declarative(const struct keybinding *keybinding) {
+	return config_kind(keybinding->action) >= 0;
+}
+
+static const char *
+entry_name(const struct cg_config_entry *entry) {
+	switch(entry->kind) {
+	case CG_CONFIG_OUTPUT:
+		return entry->kb->data.o_cfg->output_name;
+	case CG_CONFIG_INPUT:
+		return entry->kb->data.i_cfg->identifier;
+	default:
+		return "";
+	}
+}
+
+/* Orders entries by what they configure, ignoring the line */
+static int
+compare_targets(const struct cg_config_entry *x,
+                const struct cg_config_entry *y) {
+	if(x->kind != y->kind) {
+		return x->kind < y->kind ? -1 : 1;
+	}
+	if(x->kind == CG_CONFIG_BINDING) {
+		const struct keybinding *a = x->kb->data.kb, *b = y->kb->data.kb;
+		if(a->mode != b->mode) {
+			return a->mode < b->mode ? -1 : 1;
+		}
+		if(a->modifiers != b->modifiers) {
+			return a->modifiers < b->modifiers ? -1 : 1;
+		}
+		return (a->key > b->key) - (a->key < b->key);
+	}
+	return strcmp(entry_name(x), entry_name(y));
+}
+
+static int
+compare_entries(const void *a, const void *b) {
+	const struct cg_config_entry *x = a, *y = b;
+	int cmp = compare_targets(x, y);
+	if(cmp != 0) {
+		return cmp;
+	}
+	return (x->line > y->line) - (x->line < y->line);
+}
+
+static void
+config_model_free(struct cg_config_model *model) {
+	for(size_t i = 0; i < model->len; ++i) {
+		keybinding_free(model->entries[i].kb, true);
+	}
+	free(model->entries);
+	for(size_t i = 0; i < model->nmodes; ++i) {
+		free(model->modes[i]);
+	}
+	free(model->modes);
+}
+
+/* Appends name to the modes of server, such that the following lines can
+ * refer to it, without defining it yet. The mode is removed again by
+ * config_model_define_modes. Takes ownership of name on success. */
+static int
+config_model_add_mode(struct cg_server *server, struct cg_config_model *model,
+                      char *name) {
+	size_t len = 0;
+	while(server->modes[len] != NULL) {
+		++len;
+	}
+	char **modes = realloc(model->modes, (model->nmodes + 1) * sizeof(char *));
+	if(modes == NULL) {
+		return -1;
+	}
+	model->modes = modes;
+	modes = realloc(server->modes, (len + 2) * sizeof(char *));
+	if(modes == NULL) {
+		return -1;
+	}
+	server->modes = modes;
+	server->modes[len] = name;
+	server->modes[len + 1] = NULL;
+	model->modes[model->nmodes++] = name;
+	return 0;
+}
+
+/* Removes the modes added by config_model_add_mode from the modes of server
+ * and defines them with "definemode" if define is set */
+static void
+config_model_define_modes(struct cg_server *server,
+                          const struct cg_config_model *model, bool define) {
+	if(model->nmodes == 0) {
+		return;
+	}
+	size_t len = 0;
+	while(server->modes[len] != NULL) {
+		++len;
+	}
+	server->modes[len - model->nmodes] = NULL;
+	if(!define) {
+		return;
+	}
+	for(size_t i = 0; i < model->nmodes; ++i) {
+		union keybinding_params data = {.c = model->modes[i]};
+		run_action(KEYBINDING_DEFINEMODE, server, data);
+	}
+}
+
+static int
+config_model_push(struct cg_config_model *model,
+                  const struct cg_config_entry *entry) {
+	if(model->len == model->cap) {
+		size_t cap = model->cap == 0 ? 64 : model->cap * 2;
+		struct cg_config_entry *entries =
+		    realloc(model->entries, cap * sizeof(struct cg_config_entry));
+		if(entries == NULL) {
+			return -1;
+		}
+		model->entries = entries;
+		model->cap = cap;
+	}
+	model->entries[model->len++] = *entry;
+	return 0;
+}
+
+/* Parses the len bytes of text into model without running any commands. If
+ * define_modes is set, modes of "definemode" lines which do not exist yet
+ * are added with config_model_add_mode. Returns the number of the offending
+ * line if a line cannot be parsed and strict is set, -1 if memory runs out
+ * and 0 otherwise. */
+static int
+config_model_build(struct cg_server *server, struct cg_config_model *model,
+                   const char *text, size_t len, bool define_modes,
+                   bool strict) {
+	char *scratch = malloc(len + 1);
+	if(scratch == NULL) {
+		return -1;
+	}
+	memcpy(scratch, text, len);
+	scratch[len] = '\0';
+
+	int ret = 0;
+	char *end = scratch + len;
+	char *line = scratch;
+	for(uint32_t line_num = 1; line < end; ++line_num) {
+		char *nl = memchr(line, '\n', end - line);
+		if(nl == NULL) {
+			nl = end;
+		}
+		*nl = '\0';
+		if(*line == '\0' || *line == '#') {
+			line = nl + 1;
+			continue;
+		}
+		struct cg_config_entry entry = {
+		    .line = line_num,
+		    .text = text + (line - scratch),
+		    .text_len = nl - line,
+		};
+		entry.kb = malloc(sizeof(struct keybinding));
+		if(entry.kb == NULL) {
+			ret = -1;
+			break;
+		}
+		char *errstr = NULL;
+		if(parse_command(server, entry.kb, line, &errstr, 1) != 0) {
+			free(entry.kb);
+			if(errstr != NULL) {
+				free(errstr);
+			}
+			if(strict) {
+				ret = line_num;
+				break;
+			}
+			line = nl + 1;
+			continue;
+		}
+		int kind = config_kind(entry.kb->action);
+		if(entry.kb->action == KEYBINDING_DEFINEMODE && define_modes &&
+		   get_mode_index_from_name(server->modes, entry.kb->data.c) < 0) {
+			if(config_model_add_mode(server, model, entry.kb->data.c) != 0) {
+				keybinding_free(entry.kb, true);
+				ret = -1;
+				break;
+			}
+			entry.kb->data.c = NULL;
+		}
+		if(kind < 0) {
+			keybinding_free(entry.kb, true);
+		} else {
+			entry.kind = kind;
+			if(config_model_push(model, &entry) != 0) {
+				keybinding_free(entry.kb, true);
+				ret = -1;
+				break;
+			}
+		}
+		line = nl + 1;
+	}
+	free(scratch);
+	if(ret == 0) {
+		qsort(model->entries, model->len, sizeof(struct cg_config_entry),
+		      compare_entries);
+	}
+	return ret;
+}
+
+static size_t
+group_end(const struct cg_config_model *model, size_t start) {
+	size_t end = start + 1;
+	while(end < model->len && compare_targets(&model->entries[start],
+	                                          &model->entries[end]) == 0) {
+		++end;
+	}
+	return end;
+}
+
+static bool
+groups_equal(const struct cg_config_entry *a, size_t na,
+             const struct cg_config_entry *b, size_t nb) {
+	if(na != nb) {
+		return false;
+	}
+	for(size_t i = 0; i < na; ++i) {
+		if(a[i].text_len != b[i].text_len ||
+		   memcmp(a[i].text, b[i].text, a[i].text_len) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void
+remove_output_configs(struct cg_server *server, const char *name) {
+	struct cg_output_config *config, *tmp;
+	wl_list_for_each_safe(config, tmp, &server->output_config, link) {
+		if(strcmp(config->output_name, name) == 0) {
+			wl_list_remove(&config->link);
+			free(config->output_name);
+			free(config);
+		}
+	}
+}
+
+static void
+reload_chords(struct cg_server *server, struct cg_config_entry *entries,
+              size_t n) {
+	struct cg_chords *chords = chord_create();
+	if(chords == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for chords");
+		return;
+	}
+	struct cg_chords *old_chords = server->chords;
+	server->chords = chords;
+	for(size_t i = 0; i < n; ++i) {
+		run_action(entries[i].kb->action, server, entries[i].kb->data);
+		if(entries[i].kb->action == KEYBINDING_DEFINECHORD) {
+			// Now owned by the automaton or already freed
+			entries[i].kb->data.ch->kb = NULL;
+		}
+	}
+	if(server->seat != NULL) {
+		seat_reset_chord(server->seat);
+	}
+	chord_free(old_chords);
+}
+
+/* Replaces what the old entries configured by the new ones. Either of the
+ * groups may be empty, settings which are not given anymore are kept,
+ * except for keybindings, which are removed. */
+static void
+reload_group(struct cg_server *server, const struct cg_config_entry *old,
+             size_t nold, struct cg_config_entry *new, size_t nnew,
+             struct cg_reload_stats *stats) {
+	const struct cg_config_entry *any = nnew > 0 ? new : old;
+	switch(any->kind) {
+	case CG_CONFIG_BINDING:
+		if(nnew == 0) {
+			keybinding_list_remove(server->keybindings,
+			                       old[nold - 1].kb->data.kb);
+		} else {
+			struct keybinding *kb = new[nnew - 1].kb;
+			run_action(KEYBINDING_DEFINEKEY, server, kb->data);
+			kb->data.kb = NULL;
+		}
+		++stats->bindings;
+		break;
+	case CG_CONFIG_CHORD:
+		reload_chords(server, new, nnew);
+		stats->chords = true;
+		break;
+	case CG_CONFIG_OUTPUT: {
+		const char *name = entry_name(any);
+		remove_output_configs(server, name);
+		for(size_t i = 0; i < nnew; ++i) {
+			keybinding_add_output_config(server, new[i].kb->data.o_cfg);
+		}
+		keybinding_apply_output_config(server, name);
+		++stats->outputs;
+		break;
+	}
+	case CG_CONFIG_INPUT:
+		input_manager_remove_input_configs(server, entry_name(any));
+		for(size_t i = 0; i < nnew; ++i) {
+			input_manager_insert_input_config(server, new[i].kb->data.i_cfg);
+		}
+		++stats->inputs;
+		break;
+	case CG_CONFIG_MESSAGE:
+		if(nnew == 0) {
+			break;
+		}
+		for(size_t i = 0; i < nnew; ++i) {
+			run_action(KEYBINDING_CONFIGURE_MESSAGE, server,
+			           new[i].kb->data);
+		}
+		stats->message = true;
+		break;
+	case CG_CONFIG_BACKGROUND:
+		if(nnew == 0) {
+			break;
+		}
+		run_action(KEYBINDING_BACKGROUND, server, new[nnew - 1].kb->data);
+		stats->background = true;
+		break;
+	}
+}
+
+static void
+reload_diff(struct cg_server *server, const struct cg_config_model *old,
+            struct cg_config_model *new, struct cg_reload_stats *stats) {
+	size_t i = 0, j = 0;
+	while(i < old->len || j < new->len) {
+		int cmp;
+		if(i == old->len) {
+			cmp = 1;
+		} else if(j == new->len) {
+			cmp = -1;
+		} else {
+			cmp = compare_targets(&old->entries[i], &new->entries[j]);
+		}
+		size_t i_end = cmp <= 0 ? group_end(old, i) : i;
+		size_t j_end = cmp >= 0 ? group_end(new, j) : j;
+		if(!groups_equal(&old->entries[i], i_end - i, &new->entries[j],
+		                 j_end - j)) {
+			reload_group(server, &old->entries[i], i_end - i,
+			             &new->entries[j], j_end - j, stats);
+		}
+		i = i_end;
+		j = j_end;
+	}
+}
+
+static void
+config_reload_now(struct cg_server *server) {
+	size_t len;
+	char *text = read_file(server->config_path, &len);
+	if(text == NULL) {
+		wlr_log_errno(WLR_ERROR, "Could not read config file \"%s\"",
+		              server->config_path);
+		message_printf(server->curr_output, "Could not read config file");
+		return;
+	}
+
+	struct cg_config_model old = {0}, new = {0};
+	int ret = config_model_build(server, &new, text, len, true, true);
+	if(ret == 0) {
+		ret = config_model_build(server, &old, server->config_text,
+		                         strlen(server->config_text), false, false);
+	}
+	/* Only define the new modes once the whole file could be parsed */
+	config_model_define_modes(server, &new, ret == 0);
+	if(ret != 0) {
+		if(ret > 0) {
+			wlr_log(WLR_ERROR,
+			        "Error in config file \"%s\", line %d, not reloading",
+			        server->config_path, ret);
+			message_printf(server->curr_output,
+			               "Error in config file, line %d", ret);
+		} else {
+			wlr_log(WLR_ERROR, "Failed to allocate memory for reloading "
+			                   "the configuration");
+		}
+		config_model_free(&old);
+		config_model_free(&new);
+		free(text);
+		return;
+	}
+
+	/* Running key repeats refer to keybindings which may be replaced */
+	if(server->seat != NULL) {
+		seat_disarm_key_repeats(server->seat);
+	}
+	struct cg_reload_stats stats = {0};
+	reload_diff(server, &old, &new, &stats);
+	if(stats.inputs > 0) {
+		cg_input_manager_configure(server, NULL);
+	}
+	config_model_free(&old);
+	config_model_free(&new);
+	free(server->config_text);
+	server->config_text = text;
+
+	wlr_log(WLR_INFO,
+	        "Reloaded \"%s\": %u keybindings, %u outputs and %u inputs changed",
+	        server->config_path, stats.bindings, stats.outputs, stats.inputs);
+	ipc_send_event(server,
+	               "{\"event_name\":\"reload\",\"keybindings\":%u,"
+	               "\"outputs\":%u,\"inputs\":%u,\"chords\":%d,"
+	               "\"message\":%d,\"background\":%d}",
+	               stats.bindings, stats.outputs, stats.inputs, stats.chords,
+	               stats.message, stats.background);
+}
+
+static void
+handle_reload(void *data) {
+	struct cg_server *server = data;
+	server->reload_idle = NULL;
+	config_reload_now(server);
+}
+
+/* Schedules a reload of the configuration file. It happens once control
+ * returns to the event loop, since the keybinding which triggered it may be
+ * replaced. */
+void
+config_reload(struct cg_server *server) {
+	if(server->config_path == NULL || server->reload_idle != NULL) {
+		return;
+	}
+	server->reload_idle =
+	    wl_event_loop_add_idle(server->event_loop, handle_reload, server);
+	if(server->reload_idle == NULL) {
+		wlr_log(WLR_ERROR, "Failed to schedule configuration reload");
+	}
+}
@@ -0,0 +1,17 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_RELOAD_H
+#define CG_RELOAD_H
+
+#include <stdbool.h>
+
+struct cg_server;
+struct keybinding;
+
+void
+config_reload(struct cg_server *server);
+bool
+reload_is_declarative(const struct keybinding *keybinding);
+
+#endif
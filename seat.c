@@ -5,17 +5,22 @@
 
 #include "config.h"
 
+#include <inttypes.h>
 #include <linux/input-event-codes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <wayland-server-core.h>
 #include <wayland-server-protocol.h>
 #include <wlr/backend.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_cursor.h>
+#include <wlr/types/wlr_cursor_shape_v1.h>
 #include <wlr/types/wlr_data_device.h>
 #include <wlr/types/wlr_idle_notify_v1.h>
 #include <wlr/types/wlr_keyboard_group.h>
+#include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_pointer_constraints_v1.h>
 #include <wlr/types/wlr_primary_selection.h>
 #include <wlr/types/wlr_relative_pointer_v1.h>
@@ -29,12 +34,15 @@
 #include <wlr/xwayland.h>
 #endif
 
+#include "chord.h"
 #include "input_manager.h"
+#include "input_record.h"
 #include "keybinding.h"
 #include "message.h"
 #include "output.h"
 #include "seat.h"
 #include "server.h"
+#include "util.h"
 #include "view.h"
 #include "workspace.h"
 #if CG_HAS_XWAYLAND
@@ -64,13 +72,12 @@ update_capabilities(const struct cg_seat *seat) {
 	   seat->enable_cursor == false) {
 		// Only unset cursor image if renderer is available
 		if(seat->server->renderer) {
-			wlr_cursor_unset_image(seat->cursor);
+			seat_unset_cursor_image(seat);
 		}
 	} else {
 		// Only set cursor image if renderer is available
 		if(seat->server->renderer) {
-			wlr_cursor_set_xcursor(seat->cursor, seat->xcursor_manager,
-			                       DEFAULT_XCURSOR);
+			seat_set_xcursor(seat, DEFAULT_XCURSOR);
 		}
 	}
 }
@@ -151,6 +158,21 @@ new_pointer(struct cg_seat *seat, struct cg_input_device *input_device) {
 	}
 }
 
+/* Runs the repeated keybinding of group count times as a single action.
+ * Resizes are merged by adding up their offsets, other actions are run
+ * once. */
+static void
+run_repeat_action(struct cg_keyboard_group *group, uint32_t count) {
+	struct keybinding *kb = *group->repeat_keybinding;
+	union keybinding_params data = kb->data;
+	if(kb->action == KEYBINDING_RESIZE_TILE_HORIZONTAL ||
+	   kb->action == KEYBINDING_RESIZE_TILE_VERTICAL) {
+		data.is[0] = (int32_t)data.is[0] * (int32_t)count;
+	}
+	group->repeat_wait_frame = true;
+	run_action(kb->action, group->seat->server, data);
+}
+
 static int
 handle_keyboard_repeat(void *data) {
 	struct cg_keyboard_group *cg_group = data;
@@ -163,20 +185,201 @@ handle_keyboard_repeat(void *data) {
 				wlr_log(WLR_DEBUG, "failed to update key repeat timer");
 			}
 		}
-		run_action((*cg_group->repeat_keybinding)->action,
-		           cg_group->seat->server,
-		           (*cg_group->repeat_keybinding)->data);
+		/* The result of the last repeat has not been drawn yet, keep the
+		 * repeat until the next frame of the current output. Without an
+		 * enabled output no frame comes, so repeats are run right away. */
+		struct cg_output *output = cg_group->seat->server->curr_output;
+		if(output == NULL || !output->wlr_output->enabled) {
+			cg_group->repeat_pending = 0;
+			cg_group->repeat_wait_frame = false;
+		}
+		if(cg_group->repeat_wait_frame) {
+			if(cg_group->repeat_pending < CG_KEY_REPEAT_MAX_PENDING) {
+				++cg_group->repeat_pending;
+			}
+			wlr_output_schedule_frame(output->wlr_output);
+			return 0;
+		}
+		run_repeat_action(cg_group, 1);
 	}
 	return 0;
 }
 
+/* Runs the key repeats which accumulated until the last frame as one
+ * action */
+static void
+handle_repeat_idle(void *data) {
+	struct cg_seat *seat = data;
+	seat->repeat_idle = NULL;
+	struct cg_keyboard_group *group, *tmp;
+	wl_list_for_each_safe(group, tmp, &seat->keyboard_groups, link) {
+		if(group->repeat_pending > 0 && group->repeat_keybinding != NULL) {
+			uint32_t count = group->repeat_pending;
+			group->repeat_pending = 0;
+			run_repeat_action(group, count);
+		} else {
+			group->repeat_wait_frame = false;
+		}
+	}
+}
+
+/* Called when the current output is drawn. The actions may change or
+ * destroy the output, so they are run once the frame is done. */
+void
+seat_schedule_key_repeats(struct cg_seat *seat) {
+	if(seat->repeat_idle != NULL) {
+		return;
+	}
+	bool waiting = false;
+	struct cg_keyboard_group *group;
+	wl_list_for_each(group, &seat->keyboard_groups, link) {
+		waiting = waiting || group->repeat_wait_frame;
+	}
+	if(!waiting) {
+		return;
+	}
+	seat->repeat_idle = wl_event_loop_add_idle(seat->server->event_loop,
+	                                           handle_repeat_idle, seat);
+	if(seat->repeat_idle == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create idle source for key repeats");
+	}
+}
+
+static void
+send_activity(struct cg_seat *seat) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	seat->activity_sent_ns = timespec_to_ns(&now);
+	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+}
+
+static int
+handle_activity_timer(void *data) {
+	struct cg_seat *seat = data;
+	seat->activity_pending = false;
+	if(seat->activity_ns > seat->activity_sent_ns) {
+		send_activity(seat);
+	}
+	return 0;
+}
+
+/* Records input activity. It is forwarded to the idle notifier right away if
+ * the last notification is older than idle_interval and otherwise once the
+ * interval has passed, so that idle timeouts are late by at most that much. */
+void
+seat_notify_activity(struct cg_seat *seat) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	seat->activity_ns = timespec_to_ns(&now);
+
+	uint64_t interval = (uint64_t)seat->server->idle_interval * 1000000;
+	uint64_t elapsed = seat->activity_ns - seat->activity_sent_ns;
+	if(seat->activity_sent_ns == 0 || elapsed >= interval) {
+		send_activity(seat);
+		return;
+	}
+	if(seat->activity_pending) {
+		return;
+	}
+	if(seat->activity_timer == NULL) {
+		seat->activity_timer = wl_event_loop_add_timer(
+		    seat->server->event_loop, handle_activity_timer, seat);
+		if(seat->activity_timer == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create timer for idle activity");
+			send_activity(seat);
+			return;
+		}
+	}
+	seat->activity_pending = true;
+	wl_event_source_timer_update(seat->activity_timer,
+	                             (interval - elapsed + 999999) / 1000000);
+}
+
+/* Forwards the next activity right away, used when the idle state changes
+ * for other reasons than input, like an idle inhibitor going away */
+void
+seat_reset_activity(struct cg_seat *seat) {
+	seat->activity_sent_ns = 0;
+}
+
+/* Accounts the time since the backend read an input event with the given
+ * timestamp. Timestamps more than a few seconds off come from another clock,
+ * like those of nested backends or replayed events, and are ignored. */
+static void
+account_input_latency(struct cg_seat *seat, enum cg_input_class class,
+                      uint32_t time_msec) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t now_us = timespec_to_ns(&now) / 1000;
+	uint32_t delta_ms = (uint32_t)(now_us / 1000) - time_msec;
+	if(delta_ms > 10000) {
+		return;
+	}
+	uint64_t us = (uint64_t)delta_ms * 1000 + now_us % 1000;
+
+	struct cg_input_latency *latency = &seat->input_latency[class];
+	uint32_t bucket = 0;
+	while(bucket < CG_INPUT_LATENCY_BUCKETS - 1 && (1ull << bucket) <= us) {
+		++bucket;
+	}
+	++latency->count;
+	latency->total_us += us;
+	if(us > latency->max_us) {
+		latency->max_us = us;
+	}
+	++latency->histogram[bucket];
+}
+
+static char *
+print_input_latency(const struct cg_input_latency *latency, const char *name) {
+	char *histogram = strdup("");
+	for(uint32_t i = 0; histogram != NULL && i < CG_INPUT_LATENCY_BUCKETS;
+	    ++i) {
+		char *tmp = malloc_vsprintf("%s%s%" PRIu32, histogram,
+		                            i == 0 ? "" : ",", latency->histogram[i]);
+		free(histogram);
+		histogram = tmp;
+	}
+	if(histogram == NULL) {
+		return NULL;
+	}
+	char *str = malloc_vsprintf(
+	    "\"%s\":{\"count\":%" PRIu32 ",\"avg_us\":%" PRIu64
+	    ",\"max_us\":%" PRIu64 ",\"histogram\":[%s]}",
+	    name, latency->count,
+	    latency->count == 0 ? 0 : latency->total_us / latency->count,
+	    latency->max_us, histogram);
+	free(histogram);
+	return str;
+}
+
+void
+seat_send_input_stats(struct cg_seat *seat) {
+	struct cg_input_latency *latency = seat->input_latency;
+	char *keyboard =
+	    print_input_latency(&latency[CG_INPUT_CLASS_KEYBOARD], "keyboard");
+	char *pointer =
+	    print_input_latency(&latency[CG_INPUT_CLASS_POINTER], "pointer");
+	char *touch = print_input_latency(&latency[CG_INPUT_CLASS_TOUCH], "touch");
+	if(keyboard == NULL || pointer == NULL || touch == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for input statistics");
+	} else {
+		ipc_send_event(seat->server,
+		               "{\"event_name\":\"input_stats\",%s,%s,%s}",
+		               keyboard, pointer, touch);
+	}
+	free(keyboard);
+	free(pointer);
+	free(touch);
+}
+
 static void
 handle_modifier_event(struct wlr_input_device *device, struct cg_seat *seat) {
 	struct wlr_keyboard *keyboard = wlr_keyboard_from_input_device(device);
 	wlr_seat_set_keyboard(seat->seat, keyboard);
 	wlr_seat_keyboard_notify_modifiers(seat->seat, &keyboard->modifiers);
 
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	seat_notify_activity(seat);
 }
 
 void
@@ -185,11 +388,69 @@ keyboard_disarm_key_repeat(struct cg_keyboard_group *group) {
 		return;
 	}
 	group->repeat_keybinding = NULL;
+	group->repeat_pending = 0;
+	group->repeat_wait_frame = false;
 	if(wl_event_source_timer_update(group->key_repeat_timer, 0) < 0) {
 		wlr_log(WLR_DEBUG, "failed to disarm key repeat timer");
 	}
 }
 
+static int
+handle_chord_timeout(void *data) {
+	struct cg_seat *seat = data;
+	seat->chord_state = 0;
+	return 0;
+}
+
+void
+seat_reset_chord(struct cg_seat *seat) {
+	seat->chord_state = 0;
+	if(seat->chord_timer != NULL) {
+		wl_event_source_timer_update(seat->chord_timer, 0);
+	}
+}
+
+/* Stops all key repeats, which point into the keybinding list */
+void
+seat_disarm_key_repeats(struct cg_seat *seat) {
+	struct cg_keyboard_group *group;
+	wl_list_for_each(group, &seat->keyboard_groups, link) {
+		keyboard_disarm_key_repeat(group);
+	}
+}
+
+/* Moves the chord automaton to state and runs the bound action once the
+ * chord is complete. Intermediate steps only rearm the timeout. */
+static bool
+advance_chord(struct cg_seat *seat, uint32_t state) {
+	struct cg_server *server = seat->server;
+	struct keybinding *kb = chord_binding(server->chords, state);
+	if(kb == NULL) {
+		seat->chord_state = state;
+		if(server->chords->timeout == 0) {
+			return true;
+		}
+		if(seat->chord_timer == NULL) {
+			seat->chord_timer = wl_event_loop_add_timer(
+			    server->event_loop, handle_chord_timeout, seat);
+			if(seat->chord_timer == NULL) {
+				wlr_log(WLR_ERROR, "Failed to create timer for chords");
+				return true;
+			}
+		}
+		wl_event_source_timer_update(seat->chord_timer,
+		                             server->chords->timeout);
+		return true;
+	}
+	seat_reset_chord(seat);
+	wlr_log(WLR_DEBUG, "Recognized chord (key: %d, mode: %d, modifiers: %d)",
+	        kb->key, kb->mode, kb->modifiers);
+	message_clear(server->curr_output);
+	run_action(kb->action, server, kb->data);
+	seat_notify_activity(seat);
+	return true;
+}
+
 static bool
 handle_command_key_bindings(struct cg_server *server, xkb_keysym_t sym,
                             uint32_t modifiers, uint32_t mode,
@@ -197,9 +458,27 @@ handle_command_key_bindings(struct cg_server *server, xkb_keysym_t sym,
 	if(group->enable_keybindings == false) {
 		return false;
 	}
-	struct keybinding **keybinding = find_keybinding(
-	    server->keybindings,
-	    &(struct keybinding){.key = sym, .mode = mode, .modifiers = modifiers});
+	struct cg_seat *seat = server->seat;
+	if(seat->chord_state != 0) {
+		/* Inside a chord, only the automaton is consulted */
+		uint32_t state =
+		    chord_step(server->chords, seat->chord_state, modifiers, sym);
+		if(state == 0) {
+			seat_reset_chord(seat);
+			message_printf(server->curr_output, "unbound key pressed");
+			return true;
+		}
+		return advance_chord(seat, state);
+	}
+	uint32_t chord =
+	    chord_step(server->chords, chord_root(mode), modifiers, sym);
+	struct keybinding **keybinding = NULL;
+	if(chord == 0) {
+		keybinding = find_keybinding(
+		    server->keybindings,
+		    &(struct keybinding){
+		        .key = sym, .mode = mode, .modifiers = modifiers});
+	}
 	if(server->seat->mode != server->seat->default_mode) {
 		server->seat->mode =
 		    server->seat
@@ -208,12 +487,11 @@ handle_command_key_bindings(struct cg_server *server, xkb_keysym_t sym,
 		struct wlr_seat *wlr_seat = server->seat->seat;
 		struct wlr_surface *surface = NULL;
 
-		struct wlr_scene_node *node = wlr_scene_node_at(
-		    &server->scene->tree.node, server->seat->cursor->x,
-		    server->seat->cursor->y, &sx, &sy);
+		struct wlr_scene_node *node =
+		    seat_node_at(server->seat, server->seat->cursor->x,
+		                 server->seat->cursor->y, &sx, &sy);
 		if(server->seat->enable_cursor && server->renderer) {
-			wlr_cursor_set_xcursor(server->seat->cursor,
-			                       server->seat->xcursor_manager, "left_ptr");
+			seat_set_xcursor(server->seat, "left_ptr");
 			if(node && node->type == WLR_SCENE_NODE_BUFFER) {
 				struct wlr_scene_surface *scene_surface =
 				    wlr_scene_surface_try_from_buffer(
@@ -229,7 +507,9 @@ handle_command_key_bindings(struct cg_server *server, xkb_keysym_t sym,
 		}
 	}
 
-	if(keybinding) {
+	if(chord != 0) {
+		return advance_chord(seat, chord);
+	} else if(keybinding) {
 		wlr_log(
 		    WLR_DEBUG,
 		    "Recognized keybinding pressed (key: %d, mode: %d, modifiers: %d)",
@@ -245,7 +525,7 @@ handle_command_key_bindings(struct cg_server *server, xkb_keysym_t sym,
 		}
 		message_clear(group->seat->server->curr_output);
 		run_action((*keybinding)->action, server, (*keybinding)->data);
-		wlr_idle_notifier_v1_notify_activity(server->idle, server->seat->seat);
+		seat_notify_activity(server->seat);
 		return true;
 	} else if(mode != 0) {
 		run_action(KEYBINDING_NOOP, server, (union keybinding_params){NULL});
@@ -259,6 +539,13 @@ handle_command_key_bindings(struct cg_server *server, xkb_keysym_t sym,
 	}
 }
 
+static void
+record_input(struct cg_seat *seat, struct cg_input_event event) {
+	if(seat->server->input_recorder != NULL) {
+		input_record(seat->server, &event);
+	}
+}
+
 static bool
 key_is_modifier(const xkb_keysym_t key) {
 	switch(key) {
@@ -283,6 +570,9 @@ handle_key_event(struct cg_keyboard_group *group, struct cg_seat *seat,
                  void *data) {
 	struct wlr_keyboard_key_event *event = data;
 	struct wlr_keyboard *keyboard = &group->wlr_group->keyboard;
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_KEY,
+	                                           .code = event->keycode,
+	                                           .state = event->state});
 
 	/* Translate from libinput keycode to an xkbcommon keycode. */
 	xkb_keycode_t keycode = event->keycode + 8;
@@ -318,7 +608,8 @@ handle_key_event(struct cg_keyboard_group *group, struct cg_seat *seat,
 		                             event->keycode, event->state);
 	}
 
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	account_input_latency(seat, CG_INPUT_CLASS_KEYBOARD, event->time_msec);
+	seat_notify_activity(seat);
 }
 
 static void
@@ -501,6 +792,7 @@ remove_keyboard(struct cg_seat *seat, struct cg_input_device *keyboard) {
 			if(group->identifier != NULL) {
 				free(group->identifier);
 			}
+			free(group->config);
 			free(group);
 
 			// To prevent use-after-free conditions when handling key events,
@@ -579,13 +871,68 @@ handle_request_set_cursor(struct wl_listener *listener, void *data) {
 	if(focused_client == event->seat_client->client && seat->server->renderer) {
 		wlr_cursor_set_surface(seat->cursor, event->surface, event->hotspot_x,
 		                       event->hotspot_y);
+		free(seat->xcursor);
+		seat->xcursor = NULL;
+	}
+}
+
+/* Shapes are drawn from the xcursor theme of the seat, which is loaded once
+ * per output scale and shared by all clients, instead of each client
+ * uploading its own cursor buffers on pointer enter */
+void
+handle_request_set_cursor_shape(struct wl_listener *listener, void *data) {
+	struct cg_server *server =
+	    wl_container_of(listener, server, request_set_cursor_shape);
+	struct wlr_cursor_shape_manager_v1_request_set_shape_event *event = data;
+	struct cg_seat *seat = server->seat;
+
+	if(event->device_type != WLR_CURSOR_SHAPE_MANAGER_V1_DEVICE_TYPE_POINTER ||
+	   event->seat_client->seat != seat->seat) {
+		return;
+	}
+
+	/* As for cursor surfaces, only the client with pointer focus may set the
+	 * cursor. */
+	struct wlr_surface *focused_surface =
+	    seat->seat->pointer_state.focused_surface;
+	if(focused_surface == NULL || focused_surface->resource == NULL ||
+	   wl_resource_get_client(focused_surface->resource) !=
+	       event->seat_client->client) {
+		return;
+	}
+
+	if(server->renderer) {
+		seat_set_xcursor(seat, wlr_cursor_shape_v1_name(event->shape));
+	}
+}
+
+/* Sets the cursor to the image name of the xcursor theme and remembers the
+ * name, such that it can be set again once the theme is loaded, see
+ * deferred_init.c */
+void
+seat_set_xcursor(struct cg_seat *seat, const char *name) {
+	if(seat->xcursor == NULL || strcmp(seat->xcursor, name) != 0) {
+		free(seat->xcursor);
+		seat->xcursor = strdup(name);
 	}
+	wlr_cursor_set_xcursor(seat->cursor, seat->xcursor_manager, name);
+}
+
+void
+seat_unset_cursor_image(struct cg_seat *seat) {
+	wlr_cursor_unset_image(seat->cursor);
+	free(seat->xcursor);
+	seat->xcursor = NULL;
 }
 
 static void
 handle_touch_down(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, touch_down);
 	struct wlr_touch_down_event *event = data;
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_TOUCH_DOWN,
+	                                           .code = event->touch_id,
+	                                           .x = event->x,
+	                                           .y = event->y});
 
 	double lx, ly;
 	wlr_cursor_absolute_to_layout_coords(seat->cursor, &event->touch->base,
@@ -612,26 +959,34 @@ handle_touch_down(struct wl_listener *listener, void *data) {
 		seat->touch_ly = ly;
 	}
 
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	account_input_latency(seat, CG_INPUT_CLASS_TOUCH, event->time_msec);
+	seat_notify_activity(seat);
 }
 
 static void
 handle_touch_up(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, touch_up);
 	struct wlr_touch_up_event *event = data;
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_TOUCH_UP,
+	                                           .code = event->touch_id});
 
 	if(!wlr_seat_touch_get_point(seat->seat, event->touch_id)) {
 		return;
 	}
 
 	wlr_seat_touch_notify_up(seat->seat, event->time_msec, event->touch_id);
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	account_input_latency(seat, CG_INPUT_CLASS_TOUCH, event->time_msec);
+	seat_notify_activity(seat);
 }
 
 static void
 handle_touch_motion(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, touch_motion);
 	struct wlr_touch_motion_event *event = data;
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_TOUCH_MOTION,
+	                                           .code = event->touch_id,
+	                                           .x = event->x,
+	                                           .y = event->y});
 
 	if(!wlr_seat_touch_get_point(seat->seat, event->touch_id)) {
 		return;
@@ -666,37 +1021,144 @@ handle_touch_motion(struct wl_listener *listener, void *data) {
 		seat->touch_ly = ly;
 	}
 
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	account_input_latency(seat, CG_INPUT_CLASS_TOUCH, event->time_msec);
+	seat_notify_activity(seat);
 }
 
 static void
 handle_cursor_frame(struct wl_listener *listener,
                     __attribute__((unused)) void *_data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, cursor_frame);
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_FRAME});
 
 	wlr_seat_pointer_notify_frame(seat->seat);
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	seat_notify_activity(seat);
 }
 
 static void
 handle_cursor_axis(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, cursor_axis);
 	struct wlr_pointer_axis_event *event = data;
+	record_input(seat,
+	             (struct cg_input_event){.type = CG_INPUT_AXIS,
+	                                     .code = event->orientation,
+	                                     .state = event->source,
+	                                     .discrete = event->delta_discrete,
+	                                     .x = event->delta});
 
 	wlr_seat_pointer_notify_axis(
 	    seat->seat, event->time_msec, event->orientation, event->delta,
 	    event->delta_discrete, event->source, event->relative_direction);
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	account_input_latency(seat, CG_INPUT_CLASS_POINTER, event->time_msec);
+	seat_notify_activity(seat);
 }
 
 static void
 handle_cursor_button(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, cursor_button);
 	struct wlr_pointer_button_event *event = data;
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_BUTTON,
+	                                           .code = event->button,
+	                                           .state = event->state});
 
 	wlr_seat_pointer_notify_button(seat->seat, event->time_msec, event->button,
 	                               event->state);
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	account_input_latency(seat, CG_INPUT_CLASS_POINTER, event->time_msec);
+	seat_notify_activity(seat);
+}
+
+static void
+hit_cache_invalidate(struct cg_hit_cache *cache) {
+	if(cache->buffer != NULL) {
+		wl_list_remove(&cache->buffer_destroy.link);
+		cache->buffer = NULL;
+		cache->surface = NULL;
+	}
+}
+
+static void
+handle_hit_cache_buffer_destroy(struct wl_listener *listener,
+                                __attribute__((unused)) void *data) {
+	struct cg_hit_cache *cache =
+	    wl_container_of(listener, cache, buffer_destroy);
+	hit_cache_invalidate(cache);
+}
+
+/* Returns true if the point lx, ly is still on the cached surface */
+static bool
+hit_cache_lookup(struct cg_seat *seat, double lx, double ly, double *sx,
+                 double *sy) {
+	struct cg_hit_cache *cache = &seat->hit_cache;
+	if(cache->buffer == NULL ||
+	   cache->generation != seat->server->scene_generation ||
+	   !wlr_box_contains_point(&cache->box, lx, ly)) {
+		return false;
+	}
+	/* Commits of the surface do not change the generation, so check that
+	 * it has not been resized or moved since */
+	int nx, ny;
+	if(cache->surface->current.width != cache->box.width ||
+	   cache->surface->current.height != cache->box.height ||
+	   !wlr_scene_node_coords(&cache->buffer->node, &nx, &ny) ||
+	   nx != cache->box.x || ny != cache->box.y) {
+		return false;
+	}
+	double x = lx - cache->box.x, y = ly - cache->box.y;
+	if(!wlr_surface_point_accepts_input(cache->surface, x, y)) {
+		return false;
+	}
+	*sx = x;
+	*sy = y;
+	return true;
+}
+
+/* Like wlr_scene_node_at on the root of the scene, but skips the scene walk
+ * while the point stays inside the input region of the last surface hit */
+struct wlr_scene_node *
+seat_node_at(struct cg_seat *seat, double lx, double ly, double *sx,
+             double *sy) {
+	struct cg_hit_cache *cache = &seat->hit_cache;
+	if(hit_cache_lookup(seat, lx, ly, sx, sy)) {
+		return &cache->buffer->node;
+	}
+	hit_cache_invalidate(cache);
+
+	struct wlr_scene_node *node =
+	    wlr_scene_node_at(&seat->server->scene->tree.node, lx, ly, sx, sy);
+	if(node == NULL || node->type != WLR_SCENE_NODE_BUFFER) {
+		return node;
+	}
+	struct wlr_scene_buffer *buffer = wlr_scene_buffer_from_node(node);
+	struct wlr_scene_surface *scene_surface =
+	    wlr_scene_surface_try_from_buffer(buffer);
+	int x, y;
+	if(scene_surface == NULL || !wlr_scene_node_coords(node, &x, &y)) {
+		return node;
+	}
+	cache->generation = seat->server->scene_generation;
+	cache->buffer = buffer;
+	cache->surface = scene_surface->surface;
+	cache->box.x = x;
+	cache->box.y = y;
+	cache->box.width = scene_surface->surface->current.width;
+	cache->box.height = scene_surface->surface->current.height;
+	cache->buffer_destroy.notify = handle_hit_cache_buffer_destroy;
+	wl_signal_add(&node->events.destroy, &cache->buffer_destroy);
+	return node;
+}
+
+static bool
+tile_contains_point(struct cg_tile *tile, double lx, double ly) {
+	struct cg_output *output = tile->workspace->output;
+	if(output->destroyed ||
+	   output->workspaces[output->curr_workspace] != tile->workspace) {
+		return false;
+	}
+	struct wlr_box box = output_get_layout_box(output);
+	double ox = lx - box.x, oy = ly - box.y;
+	return tile->tile.x <= ox && tile->tile.y <= oy &&
+	       tile->tile.x + tile->tile.width >= ox &&
+	       tile->tile.y + tile->tile.height >= oy;
 }
 
 static void
@@ -706,8 +1168,7 @@ process_cursor_motion(struct cg_seat *seat, uint32_t time) {
 	struct wlr_surface *surface = NULL;
 
 	struct wlr_scene_node *node =
-	    wlr_scene_node_at(&seat->server->scene->tree.node, seat->cursor->x,
-	                      seat->cursor->y, &sx, &sy);
+	    seat_node_at(seat, seat->cursor->x, seat->cursor->y, &sx, &sy);
 
 	if(node && node->type == WLR_SCENE_NODE_BUFFER) {
 		struct wlr_scene_surface *scene_surface =
@@ -732,34 +1193,27 @@ process_cursor_motion(struct cg_seat *seat, uint32_t time) {
 		drag_icon_update_position(drag_icon);
 	}
 
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	seat_notify_activity(seat);
 
 	/* Check if cursor switched tile */
+	struct cg_hit_cache *cache = &seat->hit_cache;
+	if(cache->tile != NULL &&
+	   cache->tile_generation == seat->server->layout_generation &&
+	   cache->tile == seat->cursor_tile &&
+	   tile_contains_point(cache->tile, seat->cursor->x, seat->cursor->y)) {
+		return;
+	}
+	cache->tile = NULL;
 	struct wlr_output *c_outp = wlr_output_layout_output_at(
 	    seat->server->output_layout, seat->cursor->x, seat->cursor->y);
-	struct cg_output *cg_outp = NULL;
-	wl_list_for_each(cg_outp, &seat->server->outputs, link) {
-		if(cg_outp->wlr_output == c_outp) {
-			break;
-		}
-	}
 	if(c_outp) {
-		struct cg_tile *c_tile;
-		bool first = true;
-		for(c_tile = cg_outp->workspaces[cg_outp->curr_workspace]->focused_tile;
-		    first ||
-		    c_tile !=
-		        cg_outp->workspaces[cg_outp->curr_workspace]->focused_tile;
-		    c_tile = c_tile->next) {
-			first = false;
-			double ox = seat->cursor->x, oy = seat->cursor->y;
-			wlr_output_layout_output_coords(seat->server->output_layout, c_outp,
-			                                &ox, &oy);
-			if(c_tile->tile.x <= ox && c_tile->tile.y <= oy &&
-			   c_tile->tile.x + c_tile->tile.width >= ox &&
-			   c_tile->tile.y + c_tile->tile.height >= oy) {
-				break;
-			}
+		struct cg_output *cg_outp = c_outp->data;
+		struct cg_workspace *ws = cg_outp->workspaces[cg_outp->curr_workspace];
+		struct wlr_box box = output_get_layout_box(cg_outp);
+		struct cg_tile *c_tile = workspace_tile_at(
+		    ws, seat->cursor->x - box.x, seat->cursor->y - box.y);
+		if(c_tile == NULL) {
+			c_tile = ws->focused_tile;
 		}
 		if(seat->cursor_tile != NULL && seat->cursor_tile != c_tile &&
 		   seat->server->running) {
@@ -775,6 +1229,38 @@ process_cursor_motion(struct cg_seat *seat, uint32_t time) {
 			    c_tile->id);
 		}
 		seat->cursor_tile = c_tile;
+		cache->tile = c_tile;
+		cache->tile_generation = seat->server->layout_generation;
+	}
+}
+
+static void
+handle_motion_idle(void *data) {
+	struct cg_seat *seat = data;
+	seat->motion_idle = NULL;
+	process_cursor_motion(seat, -1);
+}
+
+/* As long as the cursor stays inside the surface it is focused on, the
+ * motion is sent to it directly and the full processing is only done once
+ * all pending input events are handled. */
+static void
+process_pointer_motion(struct cg_seat *seat, uint32_t time) {
+	struct wlr_surface *surface = seat->seat->pointer_state.focused_surface;
+	double sx, sy;
+	if(surface == NULL || seat->seat->drag != NULL ||
+	   !hit_cache_lookup(seat, seat->cursor->x, seat->cursor->y, &sx, &sy) ||
+	   seat->hit_cache.surface != surface) {
+		process_cursor_motion(seat, time);
+		return;
+	}
+	wlr_seat_pointer_notify_motion(seat->seat, time, sx, sy);
+	if(seat->motion_idle == NULL) {
+		seat->motion_idle = wl_event_loop_add_idle(
+		    seat->server->event_loop, handle_motion_idle, seat);
+		if(seat->motion_idle == NULL) {
+			process_cursor_motion(seat, -1);
+		}
 	}
 }
 
@@ -951,17 +1437,24 @@ handle_cursor_motion_absolute(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat =
 	    wl_container_of(listener, seat, cursor_motion_absolute);
 	struct wlr_pointer_motion_absolute_event *event = data;
+	record_input(seat,
+	             (struct cg_input_event){.type = CG_INPUT_MOTION_ABSOLUTE,
+	                                     .x = event->x,
+	                                     .y = event->y});
 
 	wlr_cursor_warp_absolute(seat->cursor, &event->pointer->base, event->x,
 	                         event->y);
-	process_cursor_motion(seat, event->time_msec);
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	process_pointer_motion(seat, event->time_msec);
+	account_input_latency(seat, CG_INPUT_CLASS_POINTER, event->time_msec);
 }
 
 static void
 handle_cursor_motion(struct wl_listener *listener, void *data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, cursor_motion);
 	struct wlr_pointer_motion_event *event = data;
+	record_input(seat, (struct cg_input_event){.type = CG_INPUT_MOTION,
+	                                           .x = event->delta_x,
+	                                           .y = event->delta_y});
 
 	wlr_relative_pointer_manager_v1_send_relative_motion(
 	    seat->server->relative_pointer_manager, seat->seat,
@@ -975,8 +1468,7 @@ handle_cursor_motion(struct wl_listener *listener, void *data) {
 		double sx, sy;
 		struct wlr_surface *surface = NULL;
 		struct wlr_scene_node *node =
-		    wlr_scene_node_at(&seat->server->scene->tree.node, seat->cursor->x,
-		                      seat->cursor->y, &sx, &sy);
+		    seat_node_at(seat, seat->cursor->x, seat->cursor->y, &sx, &sy);
 		if(node && node->type == WLR_SCENE_NODE_BUFFER) {
 			struct wlr_scene_surface *scene_surface =
 			    wlr_scene_surface_try_from_buffer(
@@ -1003,8 +1495,8 @@ handle_cursor_motion(struct wl_listener *listener, void *data) {
 	}
 
 	wlr_cursor_move(seat->cursor, &event->pointer->base, dx, dy);
-	process_cursor_motion(seat, event->time_msec);
-	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
+	process_pointer_motion(seat, event->time_msec);
+	account_input_latency(seat, CG_INPUT_CLASS_POINTER, event->time_msec);
 }
 
 static void
@@ -1042,6 +1534,7 @@ handle_drag_icon_destroy(struct wl_listener *listener,
 	wl_list_remove(&drag_icon->link);
 	wl_list_remove(&drag_icon->destroy.link);
 	wlr_scene_node_destroy(&drag_icon->scene_tree->node);
+	++drag_icon->seat->server->scene_generation;
 	free(drag_icon);
 }
 
@@ -1106,8 +1599,22 @@ handle_destroy(struct wl_listener *listener,
                __attribute__((unused)) void *_data) {
 	struct cg_seat *seat = wl_container_of(listener, seat, destroy);
 	wl_list_remove(&seat->destroy.link);
+	if(seat->motion_idle != NULL) {
+		wl_event_source_remove(seat->motion_idle);
+	}
+	if(seat->repeat_idle != NULL) {
+		wl_event_source_remove(seat->repeat_idle);
+	}
+	if(seat->activity_timer != NULL) {
+		wl_event_source_remove(seat->activity_timer);
+	}
+	if(seat->chord_timer != NULL) {
+		wl_event_source_remove(seat->chord_timer);
+	}
+	hit_cache_invalidate(&seat->hit_cache);
 
 	wlr_xcursor_manager_destroy(seat->xcursor_manager);
+	free(seat->xcursor);
 	wl_list_remove(&seat->cursor_motion.link);
 	wl_list_remove(&seat->cursor_motion_absolute.link);
 	wl_list_remove(&seat->cursor_button.link);
@@ -1131,6 +1638,7 @@ handle_destroy(struct wl_listener *listener,
 		if(group->identifier) {
 			free(group->identifier);
 		}
+		free(group->config);
 		free(group);
 	}
 
@@ -1330,6 +1838,7 @@ seat_set_focus(struct cg_seat *seat, struct cg_view *view) {
 
 	seat_maybe_set_constraint(seat, view->wlr_surface);
 	wlr_scene_node_raise_to_top(&view->scene_tree->node);
+	++server->scene_generation;
 	process_cursor_motion(seat, -1);
 	wlr_scene_node_set_position(
 	    &view->workspace->output->bg->node,
@@ -6,9 +6,13 @@
 
 #include <pixman.h>
 #include <wayland-server-core.h>
+#include <wlr/util/box.h>
 
 struct cg_server;
+struct cg_tile;
 struct cg_view;
+struct wlr_scene_buffer;
+struct wlr_scene_node;
 struct wlr_cursor;
 struct wlr_input_device;
 struct cg_input_device;
@@ -21,6 +25,40 @@ struct cg_input_config;
 
 #define DEFAULT_XCURSOR "left_ptr"
 #define XCURSOR_SIZE 24
+// Input latency histogram buckets, bucket i counts events taking < 2^i us
+#define CG_INPUT_LATENCY_BUCKETS 16
+// Maximum number of key repeats coalesced into a single action
+#define CG_KEY_REPEAT_MAX_PENDING 32
+
+/* Result of the last pointer hit test. It stays valid as long as
+ * cg_server::scene_generation does not change and the surface keeps its
+ * size and position. */
+struct cg_hit_cache {
+	uint32_t generation;
+	struct wlr_scene_buffer *buffer; // NULL if there is no cached surface
+	struct wlr_surface *surface;
+	struct wlr_box box; // Layout coordinates of surface
+	struct wl_listener buffer_destroy;
+
+	struct cg_tile *tile; // NULL if there is no cached tile
+	uint32_t tile_generation; // cg_server::layout_generation of tile
+};
+
+enum cg_input_class {
+	CG_INPUT_CLASS_KEYBOARD,
+	CG_INPUT_CLASS_POINTER,
+	CG_INPUT_CLASS_TOUCH,
+	CG_INPUT_CLASS_COUNT,
+};
+
+/* Time from the timestamp the backend gave an input event when reading it to
+ * the end of its handling */
+struct cg_input_latency {
+	uint32_t count;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint32_t histogram[CG_INPUT_LATENCY_BUCKETS];
+};
 
 struct cg_seat {
 	struct wlr_seat *seat;
@@ -37,12 +75,33 @@ struct cg_seat {
 	struct wlr_cursor *cursor;
 	struct cg_tile *cursor_tile;
 	struct wlr_xcursor_manager *xcursor_manager;
+	/* Name of the xcursor image last set on cursor, NULL while the cursor
+	 * shows a client surface or no image */
+	char *xcursor;
 	struct wl_listener cursor_motion;
 	struct wl_listener cursor_motion_absolute;
 	struct wl_listener cursor_button;
 	struct wl_listener cursor_axis;
 	struct wl_listener cursor_frame;
 
+	/* Pointer motion inside the surface found by the last hit test is sent
+	 * to the client right away, while the full processing is deferred until
+	 * the event loop is idle */
+	struct wl_event_source *motion_idle;
+	struct cg_hit_cache hit_cache;
+	/* Runs the key repeats coalesced until a frame of the current output,
+	 * see seat_schedule_key_repeats */
+	struct wl_event_source *repeat_idle;
+
+	/* Input activity is forwarded to the idle notifier at most once per
+	 * cg_server::idle_interval, later activity is sent when the timer fires */
+	uint64_t activity_ns;      // Time of the last input event
+	uint64_t activity_sent_ns; // Time activity was last forwarded, 0 if never
+	struct wl_event_source *activity_timer;
+	bool activity_pending;
+
+	struct cg_input_latency input_latency[CG_INPUT_CLASS_COUNT];
+
 	struct wlr_pointer_constraint_v1 *active_constraint;
 	struct wl_listener constraint_commit;
 	pixman_region32_t confine;
@@ -64,6 +123,9 @@ struct cg_seat {
 
 	uint16_t mode;
 	uint16_t default_mode;
+	/* State of the chord automaton, 0 if no chord is in progress */
+	uint32_t chord_state;
+	struct wl_event_source *chord_timer;
 
 	struct wl_shm *shm; // Shared memory
 
@@ -82,6 +144,12 @@ struct cg_keyboard_group {
 
 	struct wl_event_source *key_repeat_timer;
 	struct keybinding **repeat_keybinding;
+	/* Repeats are coalesced while the result of the previous one has not
+	 * been drawn, see seat_schedule_key_repeats */
+	uint32_t repeat_pending;
+	bool repeat_wait_frame;
+	/* Configuration last applied to the group, NULL if none */
+	struct cg_input_config *config;
 };
 
 struct cg_pointer {
@@ -123,5 +191,27 @@ seat_remove_device(struct cg_seat *seat, struct cg_input_device *device);
 void
 handle_new_pointer_constraint(struct wl_listener *listener, void *data);
 void
+handle_request_set_cursor_shape(struct wl_listener *listener, void *data);
+void
+seat_set_xcursor(struct cg_seat *seat, const char *name);
+void
+seat_unset_cursor_image(struct cg_seat *seat);
+void
 seat_maybe_set_constraint(struct cg_seat *seat, struct wlr_surface *surface);
+void
+seat_notify_activity(struct cg_seat *seat);
+void
+seat_reset_activity(struct cg_seat *seat);
+void
+seat_reset_chord(struct cg_seat *seat);
+void
+seat_disarm_key_repeats(struct cg_seat *seat);
+void
+seat_schedule_key_repeats(struct cg_seat *seat);
+void
+seat_send_input_stats(struct cg_seat *seat);
+struct wlr_scene_node *
+seat_node_at(struct cg_seat *seat, double lx, double ly, double *sx,
+             double *sy);
+
 #endif
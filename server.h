@@ -14,11 +14,17 @@
 struct cg_seat;
 struct cg_output;
 struct keybinding_list;
+struct cg_chords;
 struct wlr_output_layout;
 struct wlr_idle_inhibit_manager_v1;
 struct cg_output_config;
 struct cg_input_manager;
+struct cg_input_recorder;
+struct cg_input_replay;
+struct cg_startup_trace;
+struct cg_launcher;
 struct wlr_layer_shell_v1;
+struct wlr_cursor_shape_manager_v1;
 
 struct cg_server {
 	struct wl_display *wl_display;
@@ -58,15 +64,38 @@ struct cg_server {
 	struct wlr_relative_pointer_manager_v1 *relative_pointer_manager;
 	struct wlr_pointer_constraints_v1 *pointer_constraints;
 	struct wl_listener new_pointer_constraint;
+	struct wlr_cursor_shape_manager_v1 *cursor_shape_manager;
+	struct wl_listener request_set_cursor_shape;
 #if CG_HAS_XWAYLAND
 	struct wl_listener new_xwayland_surface;
 	struct wlr_xwayland *xwayland;
 #endif
 
 	struct keybinding_list *keybindings;
+	struct cg_chords *chords;
 	struct wl_list output_config;
 	struct wl_list input_config;
 	struct cg_message_config message_config;
+	struct wl_event_source *overlay_clock;
+	struct wl_event_source *stats_stream;
+	struct cg_input_recorder *input_recorder;
+	struct cg_input_replay *input_replay;
+	struct wl_list stopped_replays; // cg_input_replay::link
+	uint32_t stats_interval;
+	/* Path and contents of the loaded configuration file, see reload.c */
+	char *config_path;
+	char *config_text;
+	struct wl_event_source *reload_idle;
+	struct cg_startup_trace *startup_trace;
+	/* Set by --defer-init until the initialization which is not needed for
+	 * the first frame has run, see deferred_init.c */
+	bool defer_init;
+	uint32_t deferred_init_step;
+	struct wl_event_source *deferred_init;
+	struct wl_list children;     // cg_child::link
+	struct wl_list launch_stats; // cg_launch_stats::link
+	struct wl_event_source *sigchld;
+	struct cg_launcher *launcher; // NULL unless started with --launcher
 
 	struct cg_ipc_handle ipc;
 
@@ -79,6 +108,18 @@ struct cg_server {
 	float *bg_color;
 	uint32_t views_curr_id;
 	uint32_t tiles_curr_id;
+	/* Incremented whenever the scene changes in a way which may affect what
+	 * is below the cursor, like a map, an unmap, a resize or a change of the
+	 * subsurfaces, but not on commits which only update contents.
+	 * Invalidates cg_seat::hit_cache. */
+	uint32_t scene_generation;
+	/* Incremented whenever tiles are created, destroyed, moved or resized,
+	 * invalidates cg_workspace::tile_index and the tile in cg_seat::hit_cache
+	 */
+	uint32_t layout_generation;
+	/* Minimum time in milliseconds between two activity notifications sent
+	 * to the idle notifier */
+	uint32_t idle_interval;
 	uint32_t xcursor_size;
 };
 
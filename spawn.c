@@ -0,0 +1,436 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_compositor.h>
+#include <wlr/util/log.h>
+
+#include "ipc_server.h"
+#include "launcher.h"
+#include "server.h"
+#include "spawn.h"
+#include "util.h"
+#include "view.h"
+
+extern char **environ;
+
+/* Commands made of words of these characters only are run without a shell */
+static bool
+needs_shell(const char *command) {
+	for(const char *c = command; *c != '\0'; ++c) {
+		if(!isalnum((unsigned char)*c) && strchr(" _-./,:+@%", *c) == NULL) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Splits command at spaces in place. Returns a NULL-terminated array, which
+ * the caller frees, or NULL. */
+static char **
+split_command(char *command) {
+	size_t len = strlen(command);
+	char **argv = malloc((len / 2 + 2) * sizeof(char *));
+	if(argv == NULL) {
+		return NULL;
+	}
+	size_t argc = 0;
+	char *saveptr;
+	for(char *word = strtok_r(command, " ", &saveptr); word != NULL;
+	    word = strtok_r(NULL, " ", &saveptr)) {
+		argv[argc++] = word;
+	}
+	argv[argc] = NULL;
+	return argv;
+}
+
+/* Reaps the exited children. SIGCHLD is only dispatched by the event loop,
+ * so this never races with code waiting for a specific child. */
+static int
+handle_sigchld(__attribute__((unused)) int signal, void *data) {
+	struct cg_server *server = data;
+	struct cg_child *child, *tmp;
+	wl_list_for_each_safe(child, tmp, &server->children, link) {
+		if(child->launched || child->exited) {
+			continue;
+		}
+		pid_t ret = waitpid(child->pid, NULL, WNOHANG);
+		if(ret == child->pid || (ret < 0 && errno == ECHILD)) {
+			spawn_child_exited(child);
+		}
+	}
+	return 0;
+}
+
+void
+spawn_child_destroy(struct cg_child *child) {
+	wl_list_remove(&child->link);
+	free(child->command);
+	free(child);
+}
+
+/* Keeps child around until one of its descendants maps a view, unless it
+ * already did */
+void
+spawn_child_exited(struct cg_child *child) {
+	if(child->mapped) {
+		spawn_child_destroy(child);
+		return;
+	}
+	child->exited = true;
+}
+
+static void
+trim_exited_children(struct cg_server *server) {
+	uint32_t nexited = 0;
+	struct cg_child *child, *tmp;
+	wl_list_for_each(child, &server->children, link) {
+		nexited += child->exited;
+	}
+	wl_list_for_each_safe(child, tmp, &server->children, link) {
+		if(nexited < CG_SPAWN_EXITED_MAX) {
+			break;
+		}
+		if(child->exited) {
+			spawn_child_destroy(child);
+			--nexited;
+		}
+	}
+}
+
+/* Starts command with the environment envp in a new session with all
+ * signals unblocked. Commands containing shell syntax are run by "sh -c",
+ * others directly. Returns 0 or an error number. */
+int
+spawn_process(pid_t *pid, const char *command, char *const envp[]) {
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	sigset_t set;
+	sigemptyset(&set);
+	posix_spawnattr_setsigmask(&attr, &set);
+#ifdef POSIX_SPAWN_SETSID
+	posix_spawnattr_setflags(&attr,
+	                         POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSID);
+#else
+	posix_spawnattr_setflags(&attr,
+	                         POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
+#endif
+
+	int err = ENOMEM;
+	char *words = NULL;
+	char **argv = NULL;
+	if(!needs_shell(command)) {
+		words = strdup(command);
+		argv = words == NULL ? NULL : split_command(words);
+		if(words == NULL || argv == NULL) {
+			goto out;
+		}
+	}
+	if(argv != NULL && argv[0] != NULL) {
+		err = posix_spawnp(pid, argv[0], NULL, &attr, argv, envp);
+	} else {
+		char *const sh_argv[] = {"sh", "-c", (char *)command, NULL};
+		err = posix_spawnp(pid, "sh", NULL, &attr, sh_argv, envp);
+	}
+out:
+	free(argv);
+	free(words);
+	posix_spawnattr_destroy(&attr);
+	return err;
+}
+
+/* Runs command through the launcher if there is one, directly otherwise.
+ * Direct children are reaped once they exit. Returns 0 on success. */
+int
+spawn_command(struct cg_server *server, const char *command) {
+	trim_exited_children(server);
+	struct cg_child *child = calloc(1, sizeof(struct cg_child));
+	char *command_copy = strdup(command);
+	if(child == NULL || command_copy == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for child process");
+		free(child);
+		free(command_copy);
+		return -1;
+	}
+	child->command = command_copy;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	child->spawn_ns = timespec_to_ns(&start);
+
+	if(server->launcher != NULL && launcher_spawn(server, child) == 0) {
+		return 0;
+	}
+	if(server->sigchld == NULL) {
+		server->sigchld = wl_event_loop_add_signal(
+		    server->event_loop, SIGCHLD, handle_sigchld, server);
+		if(server->sigchld == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create SIGCHLD event source");
+			free(child->command);
+			free(child);
+			return -1;
+		}
+	}
+
+	pid_t pid;
+	int err = spawn_process(&pid, command, environ);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if(err != 0) {
+		wlr_log(WLR_ERROR, "Failed to run \"%s\": %s", command,
+		        strerror(err));
+		free(child->command);
+		free(child);
+		return -1;
+	}
+	wlr_log(WLR_DEBUG, "Spawned \"%s\" as %d in %.3f ms", command, pid,
+	        (timespec_to_ns(&end) - timespec_to_ns(&start)) / 1e6);
+
+	child->pid = pid;
+	wl_list_insert(server->children.prev, &child->link);
+	return 0;
+}
+
+static struct cg_child *
+child_with_pid(struct cg_server *server, pid_t pid) {
+	if(pid <= 0) {
+		return NULL;
+	}
+	struct cg_child *child;
+	wl_list_for_each(child, &server->children, link) {
+		if(child->pid == pid) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
+/* Returns the parent of pid as given by /proc, or -1 */
+static pid_t
+parent_pid(pid_t pid) {
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+	FILE *file = fopen(path, "r");
+	if(file == NULL) {
+		return -1;
+	}
+	char buf[512];
+	size_t len = fread(buf, 1, sizeof(buf) - 1, file);
+	fclose(file);
+	buf[len] = '\0';
+	/* The name of the process precedes the state and the parent, it is in
+	 * parentheses and may contain any character */
+	char *name_end = strrchr(buf, ')');
+	int ppid;
+	if(name_end == NULL || sscanf(name_end + 1, " %*c %d", &ppid) != 1) {
+		return -1;
+	}
+	return ppid;
+}
+
+/* Returns the child which started pid, either itself or through other
+ * processes, or NULL */
+static struct cg_child *
+find_child(struct cg_server *server, pid_t pid) {
+	if(pid <= 0) {
+		return NULL;
+	}
+	pid_t sid = getsid(pid);
+	pid_t pgid = getpgid(pid);
+	for(int depth = 0; pid > 1 && depth < 16; ++depth) {
+		struct cg_child *child = child_with_pid(server, pid);
+		if(child != NULL) {
+			return child;
+		}
+		pid = parent_pid(pid);
+	}
+	/* Children are started in a session (or process group) of their own,
+	 * which their descendants stay in after the child has exited */
+	struct cg_child *child = child_with_pid(server, sid);
+	return child != NULL ? child : child_with_pid(server, pgid);
+}
+
+static struct cg_launch_stats *
+launch_stats_get(struct cg_server *server, const char *command) {
+	struct cg_launch_stats *stats;
+	wl_list_for_each(stats, &server->launch_stats, link) {
+		if(strcmp(stats->command, command) == 0) {
+			return stats;
+		}
+	}
+	stats = calloc(1, sizeof(struct cg_launch_stats));
+	if(stats == NULL) {
+		return NULL;
+	}
+	stats->command = strdup(command);
+	if(stats->command == NULL) {
+		free(stats);
+		return NULL;
+	}
+	wl_list_insert(server->launch_stats.prev, &stats->link);
+	return stats;
+}
+
+/* Starts measuring the launch of view if it is the first view of a command
+ * run by "exec" */
+void
+spawn_view_map(struct cg_view *view) {
+	view->launch.stats = NULL;
+	struct cg_server *server = view->server;
+	if(wl_list_empty(&server->children)) {
+		return;
+	}
+	struct cg_child *child = find_child(server, view->impl->get_pid(view));
+	if(child == NULL || child->mapped) {
+		return;
+	}
+	struct cg_launch_stats *stats = launch_stats_get(server, child->command);
+	if(stats == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for launch statistics");
+		return;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	view->launch.stats = stats;
+	view->launch.spawn_ns = child->spawn_ns;
+	view->launch.map_ns = timespec_to_ns(&now);
+	view->launch.map_seq = view->wlr_surface->current.seq;
+	child->mapped = true;
+	if(child->exited) {
+		spawn_child_destroy(child);
+	}
+}
+
+/* Returns str as a quoted JSON string */
+static char *
+json_string(const char *str) {
+	size_t len = 3;
+	for(const char *c = str; *c != '\0'; ++c) {
+		len += (unsigned char)*c < 0x20 ? 6 : (*c == '"' || *c == '\\') + 1;
+	}
+	char *json = malloc(len);
+	if(json == NULL) {
+		return NULL;
+	}
+	char *it = json;
+	*it++ = '"';
+	for(const char *c = str; *c != '\0'; ++c) {
+		if((unsigned char)*c < 0x20) {
+			it += sprintf(it, "\\u%04x", (unsigned char)*c);
+			continue;
+		}
+		if(*c == '"' || *c == '\\') {
+			*it++ = '\\';
+		}
+		*it++ = *c;
+	}
+	*it++ = '"';
+	*it = '\0';
+	return json;
+}
+
+/* Completes the launch of view on its first commit after the map */
+void
+spawn_view_commit(struct cg_view *view) {
+	struct cg_view_launch *launch = &view->launch;
+	if(launch->stats == NULL ||
+	   view->wlr_surface->current.seq == launch->map_seq) {
+		return;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t map_ns = launch->map_ns - launch->spawn_ns;
+	uint64_t commit_ns = timespec_to_ns(&now) - launch->map_ns;
+	struct cg_launch_stats *stats = launch->stats;
+	launch->stats = NULL;
+
+	++stats->count;
+	stats->map_sum_ns += map_ns;
+	stats->commit_sum_ns += commit_ns;
+	if(map_ns > stats->map_max_ns) {
+		stats->map_max_ns = map_ns;
+	}
+	if(commit_ns > stats->commit_max_ns) {
+		stats->commit_max_ns = commit_ns;
+	}
+
+	char *command = json_string(stats->command);
+	if(command == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for launch_complete");
+		return;
+	}
+	ipc_send_event(view->server,
+	               "{\"event_name\":\"launch_complete\",\"view_id\":%d,"
+	               "\"view_pid\":%d,\"command\":%s,\"spawn_to_map_us\":%" PRIu64
+	               ",\"map_to_commit_us\":%" PRIu64 "}",
+	               view->id, view->impl->get_pid(view), command,
+	               map_ns / 1000, commit_ns / 1000);
+	free(command);
+}
+
+void
+spawn_send_launch_stats(struct cg_server *server) {
+	char *list = strdup("");
+	struct cg_launch_stats *stats;
+	wl_list_for_each(stats, &server->launch_stats, link) {
+		if(stats->count == 0) {
+			continue;
+		}
+		char *command = json_string(stats->command);
+		char *tmp = NULL;
+		if(list != NULL && command != NULL) {
+			tmp = malloc_vsprintf(
+			    "%s%s{\"command\":%s,\"count\":%" PRIu32
+			    ",\"spawn_to_map_us\":{\"avg\":%" PRIu64 ",\"max\":%" PRIu64
+			    "},\"map_to_commit_us\":{\"avg\":%" PRIu64
+			    ",\"max\":%" PRIu64 "}}",
+			    list, list[0] == '\0' ? "" : ",", command, stats->count,
+			    stats->map_sum_ns / stats->count / 1000,
+			    stats->map_max_ns / 1000,
+			    stats->commit_sum_ns / stats->count / 1000,
+			    stats->commit_max_ns / 1000);
+		}
+		free(command);
+		free(list);
+		list = tmp;
+	}
+	if(list == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for launch statistics");
+		return;
+	}
+	ipc_send_event(server,
+	               "{\"event_name\":\"launch_stats\",\"commands\":[%s]}",
+	               list);
+	free(list);
+}
+
+/* Forgets about the children without waiting for them */
+void
+spawn_finish(struct cg_server *server) {
+	struct cg_child *child, *tmp;
+	wl_list_for_each_safe(child, tmp, &server->children, link) {
+		spawn_child_destroy(child);
+	}
+	struct cg_launch_stats *stats, *stats_tmp;
+	wl_list_for_each_safe(stats, stats_tmp, &server->launch_stats, link) {
+		wl_list_remove(&stats->link);
+		free(stats->command);
+		free(stats);
+	}
+	if(server->sigchld != NULL) {
+		wl_event_source_remove(server->sigchld);
+		server->sigchld = NULL;
+	}
+}
@@ -0,0 +1,58 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_SPAWN_H
+#define CG_SPAWN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <wayland-server-core.h>
+
+struct cg_server;
+struct cg_view;
+
+// Number of exited children kept to match the views of their descendants
+#define CG_SPAWN_EXITED_MAX 16
+
+/* A process started by "exec" which has not exited yet, or which has
+ * exited before any of its views was mapped */
+struct cg_child {
+	pid_t pid;     // 0 while the launcher has not reported it yet
+	bool launched; // Child of the launcher, which reaps it
+	bool exited;
+	bool mapped; // A view of the child or its descendants was mapped
+	char *command;
+	uint64_t spawn_ns;
+	struct wl_list link; // cg_server::children, oldest first
+};
+
+/* Launch times of the first views of a command */
+struct cg_launch_stats {
+	char *command;
+	uint32_t count;
+	uint64_t map_sum_ns; // From the spawn to the map of the view
+	uint64_t map_max_ns;
+	uint64_t commit_sum_ns; // From the map to the next commit of the view
+	uint64_t commit_max_ns;
+	struct wl_list link; // cg_server::launch_stats
+};
+
+int
+spawn_process(pid_t *pid, const char *command, char *const envp[]);
+int
+spawn_command(struct cg_server *server, const char *command);
+void
+spawn_child_destroy(struct cg_child *child);
+void
+spawn_child_exited(struct cg_child *child);
+void
+spawn_view_map(struct cg_view *view);
+void
+spawn_view_commit(struct cg_view *view);
+void
+spawn_send_launch_stats(struct cg_server *server);
+void
+spawn_finish(struct cg_server *server);
+
+#endif
@@ -0,0 +1,154 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wlr/util/log.h>
+
+#include "server.h"
+#include "startup_trace.h"
+#include "util.h"
+
+static const char *const milestone_names[] = {
+    [CG_STARTUP_FIRST_FRAME] = "first_frame",
+    [CG_STARTUP_FIRST_MAP] = "first_map",
+    [CG_STARTUP_DEFERRED_INIT] = "deferred_init",
+};
+
+static uint64_t
+now_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return timespec_to_ns(&now);
+}
+
+static void
+add_event(struct cg_startup_trace *trace, const char *name, uint64_t start_ns,
+          uint64_t dur_ns) {
+	if(trace->nevents == CG_STARTUP_TRACE_EVENTS) {
+		wlr_log(WLR_ERROR, "Too many startup trace events, dropping \"%s\"",
+		        name);
+		return;
+	}
+	trace->events[trace->nevents++] = (struct cg_startup_event){
+	    .name = name, .start_ns = start_ns, .dur_ns = dur_ns};
+}
+
+void
+startup_trace_start(struct cg_server *server, const char *path) {
+	struct cg_startup_trace *trace = calloc(1, sizeof(*trace));
+	if(trace == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for startup trace");
+		return;
+	}
+	trace->path = strdup(path);
+	if(trace->path == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate memory for startup trace");
+		free(trace);
+		return;
+	}
+	trace->last_ns = now_ns();
+	trace->expected =
+	    (1u << CG_STARTUP_FIRST_FRAME) | (1u << CG_STARTUP_FIRST_MAP);
+	server->startup_trace = trace;
+}
+
+/* Ends the phase which started when the previous one ended */
+void
+startup_trace_phase(struct cg_server *server, const char *name) {
+	struct cg_startup_trace *trace = server->startup_trace;
+	if(trace == NULL) {
+		return;
+	}
+	uint64_t now = now_ns();
+	add_event(trace, name, trace->last_ns, now - trace->last_ns);
+	trace->last_ns = now;
+}
+
+/* Records work which is not part of the sequential phases, from start_ns
+ * to now */
+void
+startup_trace_span(struct cg_server *server, const char *name,
+                   uint64_t start_ns) {
+	struct cg_startup_trace *trace = server->startup_trace;
+	if(trace == NULL) {
+		return;
+	}
+	add_event(trace, name, start_ns, now_ns() - start_ns);
+}
+
+/* Delays writing the trace until milestone is reached as well */
+void
+startup_trace_expect(struct cg_server *server,
+                     enum cg_startup_milestone milestone) {
+	struct cg_startup_trace *trace = server->startup_trace;
+	if(trace != NULL) {
+		trace->expected |= 1u << milestone;
+	}
+}
+
+/* Records the first time milestone is reached. The trace is written once
+ * all expected milestones are reached. */
+void
+startup_trace_milestone(struct cg_server *server,
+                        enum cg_startup_milestone milestone) {
+	struct cg_startup_trace *trace = server->startup_trace;
+	if(trace == NULL || trace->milestones & (1u << milestone)) {
+		return;
+	}
+	trace->milestones |= 1u << milestone;
+	add_event(trace, milestone_names[milestone], now_ns(), 0);
+	if((trace->milestones & trace->expected) == trace->expected) {
+		startup_trace_finish(server);
+	}
+}
+
+/* Writes the trace in the JSON object format of the Chrome trace event
+ * format, timestamps are in microseconds */
+static void
+write_trace(const struct cg_startup_trace *trace) {
+	FILE *file = fopen(trace->path, "w");
+	if(file == NULL) {
+		wlr_log_errno(WLR_ERROR, "Failed to open startup trace \"%s\"",
+		              trace->path);
+		return;
+	}
+	uint64_t origin = trace->nevents > 0 ? trace->events[0].start_ns : 0;
+	int pid = getpid();
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for(uint32_t i = 0; i < trace->nevents; ++i) {
+		const struct cg_startup_event *event = &trace->events[i];
+		fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"startup\",", i ? "," : "",
+		        event->name);
+		if(event->dur_ns == 0) {
+			fprintf(file, "\"ph\":\"i\",\"s\":\"g\",");
+		} else {
+			fprintf(file, "\"ph\":\"X\",\"dur\":%.3f,", event->dur_ns / 1e3);
+		}
+		fprintf(file, "\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+		        (event->start_ns - origin) / 1e3, pid, pid);
+	}
+	fprintf(file, "\n]}\n");
+	if(fclose(file) != 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to write startup trace \"%s\"",
+		              trace->path);
+	}
+}
+
+/* Writes the trace with the milestones reached so far and stops tracing */
+void
+startup_trace_finish(struct cg_server *server) {
+	struct cg_startup_trace *trace = server->startup_trace;
+	if(trace == NULL) {
+		return;
+	}
+	write_trace(trace);
+	free(trace->path);
+	free(trace);
+	server->startup_trace = NULL;
+}
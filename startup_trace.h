@@ -0,0 +1,53 @@
+// Copyright 2020 - 2026, project-repo and the cagebreak contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef CG_STARTUP_TRACE_H
+#define CG_STARTUP_TRACE_H
+
+#include <stdint.h>
+
+struct cg_server;
+
+#define CG_STARTUP_TRACE_EVENTS 32
+
+enum cg_startup_milestone {
+	CG_STARTUP_FIRST_FRAME,
+	CG_STARTUP_FIRST_MAP,
+	CG_STARTUP_DEFERRED_INIT,
+	CG_STARTUP_MILESTONE_COUNT,
+};
+
+struct cg_startup_event {
+	const char *name;
+	uint64_t start_ns;
+	uint64_t dur_ns; // 0 for milestones
+};
+
+/* Durations of the startup phases, written as Chrome trace events to path
+ * once the expected milestones are reached */
+struct cg_startup_trace {
+	char *path;
+	uint64_t last_ns;    // End of the last phase
+	uint32_t milestones; // Bit mask of the reached milestones
+	uint32_t expected;   // Bit mask of the milestones to wait for
+	uint32_t nevents;
+	struct cg_startup_event events[CG_STARTUP_TRACE_EVENTS];
+};
+
+void
+startup_trace_start(struct cg_server *server, const char *path);
+void
+startup_trace_phase(struct cg_server *server, const char *name);
+void
+startup_trace_span(struct cg_server *server, const char *name,
+                   uint64_t start_ns);
+void
+startup_trace_expect(struct cg_server *server,
+                     enum cg_startup_milestone milestone);
+void
+startup_trace_milestone(struct cg_server *server,
+                        enum cg_startup_milestone milestone);
+void
+startup_trace_finish(struct cg_server *server);
+
+#endif
@@ -1,11 +1,18 @@
 // Copyright 2020 - 2026, project-repo and the cagebreak contributors
 // SPDX-License-Identifier: MIT
 
+#define _POSIX_C_SOURCE 200812L
+
 #include <wlr/util/box.h>
 
 #include "util.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <math.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 int
 scale_length(int length, int offset, double scale) {
@@ -48,3 +55,60 @@ malloc_vsprintf(const char *fmt, ...) {
 	char *ret = malloc_vsprintf_va_list(fmt, args);
 	return ret;
 }
+
+uint64_t
+timespec_to_ns(const struct timespec *ts) {
+	return (uint64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+/* Reads the whole file at path into a NUL-terminated buffer, which the caller
+ * frees. The length without the terminating NUL is stored in len. Returns
+ * NULL and sets errno on failure. */
+char *
+read_file(const char *path, size_t *len) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0) {
+		return NULL;
+	}
+	struct stat st;
+	size_t cap = 4096;
+	if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		cap = (size_t)st.st_size + 1;
+	}
+	char *buf = malloc(cap);
+	size_t size = 0;
+	while(buf != NULL) {
+		if(size + 1 == cap) {
+			char *tmp = realloc(buf, cap * 2);
+			if(tmp == NULL) {
+				free(buf);
+				buf = NULL;
+				errno = ENOMEM;
+				break;
+			}
+			buf = tmp;
+			cap *= 2;
+		}
+		ssize_t ret = read(fd, buf + size, cap - size - 1);
+		if(ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if(ret < 0) {
+			int err = errno;
+			free(buf);
+			buf = NULL;
+			errno = err;
+			break;
+		}
+		if(ret == 0) {
+			buf[size] = '\0';
+			*len = size;
+			break;
+		}
+		size += ret;
+	}
+	int err = errno;
+	close(fd);
+	errno = err;
+	return buf;
+}
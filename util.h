@@ -4,8 +4,11 @@
 #ifndef CG_UTIL_H
 #define CG_UTIL_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+struct timespec;
 struct wlr_box;
 
 /** Apply scale to a width or height. */
@@ -20,4 +23,10 @@ malloc_vsprintf(const char *fmt, ...);
 char *
 malloc_vsprintf_va_list(const char *fmt, va_list list);
 
+uint64_t
+timespec_to_ns(const struct timespec *ts);
+
+char *
+read_file(const char *path, size_t *len);
+
 #endif
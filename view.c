@@ -4,18 +4,24 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_scene.h>
+#include <wlr/types/wlr_subcompositor.h>
 #include <wlr/util/box.h>
 
 #include "ipc_server.h"
 #include "output.h"
 #include "seat.h"
 #include "server.h"
+#include "spawn.h"
+#include "startup_trace.h"
+#include "util.h"
 #include "view.h"
 #include "workspace.h"
 #if CG_HAS_XWAYLAND
@@ -87,6 +93,7 @@ view_maximize(struct cg_view *view, struct cg_tile *tile) {
 	view->impl->maximize(view, tile->tile.width, tile->tile.height);
 	view->tile = tile;
 	wlr_scene_node_raise_to_top(&view->scene_tree->node);
+	++view->server->scene_generation;
 }
 
 void
@@ -138,6 +145,9 @@ view_unmap(struct cg_view *view) {
 #endif
 
 	wl_list_remove(&view->link);
+	wl_list_remove(&view->commit.link);
+	++view->server->scene_generation;
+	view->launch.stats = NULL;
 
 	view->wlr_surface = NULL;
 	ipc_send_event(
@@ -147,11 +157,123 @@ view_unmap(struct cg_view *view) {
 	    id, tile_id, ws + 1, output_name, output_id, pid);
 }
 
+static bool
+view_on_current_workspace(const struct cg_view *view) {
+	struct cg_output *output = view->workspace->output;
+	return output->workspaces[output->curr_workspace] == view->workspace &&
+	       view_is_visible(view);
+}
+
+static uint32_t
+subsurfaces_hash(uint32_t hash, struct wl_list *subsurfaces) {
+	struct wlr_subsurface_parent_state *state;
+	wl_list_for_each(state, subsurfaces, link) {
+		struct wlr_subsurface *subsurface =
+		    wl_container_of(state, subsurface, current);
+		hash = (hash ^ (uint32_t)(uintptr_t)subsurface) * 0x01000193u;
+		hash = (hash ^ (uint32_t)state->x) * 0x01000193u;
+		hash = (hash ^ (uint32_t)state->y) * 0x01000193u;
+		hash = (hash ^ subsurface->surface->mapped) * 0x01000193u;
+	}
+	return hash;
+}
+
+/* Stores the current shape of surface in shape, returns true if it changed
+ * since the last call */
+bool
+view_surface_shape_update(struct cg_surface_shape *shape,
+                          struct wlr_surface *surface) {
+	struct cg_surface_shape current = {
+	    .width = surface->current.width,
+	    .height = surface->current.height,
+	    .subsurfaces = subsurfaces_hash(
+	        subsurfaces_hash(0x811c9dc5u, &surface->current.subsurfaces_below),
+	        &surface->current.subsurfaces_above),
+	};
+	bool changed =
+	    current.width != shape->width || current.height != shape->height ||
+	    current.subsurfaces != shape->subsurfaces ||
+	    (surface->current.committed & WLR_SURFACE_STATE_INPUT_REGION);
+	*shape = current;
+	return changed;
+}
+
+static void
+handle_view_commit(struct wl_listener *listener,
+                   __attribute__((unused)) void *data) {
+	struct cg_view *view = wl_container_of(listener, view, commit);
+	/* Commits which only update the contents of the view leave the hit
+	 * tests valid */
+	if(view_surface_shape_update(&view->shape, view->wlr_surface)) {
+		++view->server->scene_generation;
+	}
+	spawn_view_commit(view);
+	if(view->latency.committed_ns != 0 || !view_on_current_workspace(view)) {
+		return;
+	}
+	struct timespec now = {0};
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	view->latency.committed_ns = timespec_to_ns(&now);
+}
+
+static void
+view_latency_drawn_list(struct wl_list *views, uint64_t commit_ns) {
+	struct cg_view *view;
+	wl_list_for_each(view, views, link) {
+		struct cg_view_latency *latency = &view->latency;
+		if(latency->committed_ns == 0 || latency->committed_ns > commit_ns) {
+			continue;
+		}
+		if(latency->drawn_ns == 0) {
+			latency->drawn_ns = latency->committed_ns;
+		}
+		latency->committed_ns = 0;
+	}
+}
+
+/* Called when a frame started at commit_ns was committed to output */
+void
+view_latency_drawn(struct cg_output *output, uint64_t commit_ns) {
+	struct cg_workspace *ws = output->workspaces[output->curr_workspace];
+	view_latency_drawn_list(&ws->views, commit_ns);
+	view_latency_drawn_list(&ws->unmanaged_views, commit_ns);
+}
+
+static void
+view_latency_presented_list(struct wl_list *views, uint64_t when_ns) {
+	struct cg_view *view;
+	wl_list_for_each(view, views, link) {
+		struct cg_view_latency *latency = &view->latency;
+		if(latency->drawn_ns == 0 || latency->drawn_ns > when_ns) {
+			continue;
+		}
+		latency->last_ns = when_ns - latency->drawn_ns;
+		latency->sum_ns += latency->last_ns;
+		++latency->count;
+		if(latency->last_ns > latency->max_ns) {
+			latency->max_ns = latency->last_ns;
+		}
+		latency->drawn_ns = 0;
+	}
+}
+
+/* Called when the last frame committed to output was presented at when_ns */
+void
+view_latency_presented(struct cg_output *output, uint64_t when_ns) {
+	struct cg_workspace *ws = output->workspaces[output->curr_workspace];
+	view_latency_presented_list(&ws->views, when_ns);
+	view_latency_presented_list(&ws->unmanaged_views, when_ns);
+}
+
 void
 view_map(struct cg_view *view, struct wlr_surface *surface,
          struct cg_workspace *ws) {
 	struct cg_output *output = ws->output;
 	view->wlr_surface = surface;
+	view->commit.notify = handle_view_commit;
+	wl_signal_add(&surface->events.commit, &view->commit);
+	view_surface_shape_update(&view->shape, surface);
+	++view->server->scene_generation;
 
 	wlr_scene_node_reparent(&view->scene_tree->node, ws->scene);
 	if(!view->scene_tree) {
@@ -176,6 +298,10 @@ view_map(struct cg_view *view, struct wlr_surface *surface,
 		wl_list_insert(&ws->views, &view->link);
 	}
 	seat_set_focus(output->server->seat, view);
+	if(view->server->startup_trace != NULL) {
+		startup_trace_milestone(view->server, CG_STARTUP_FIRST_MAP);
+	}
+	spawn_view_map(view);
 	int tile_id = 0;
 	if(view->tile == NULL) {
 		tile_id = -1;
@@ -214,6 +340,7 @@ view_init(struct cg_view *view, enum cg_view_type type,
 	view->server = server;
 	view->type = type;
 	view->impl = impl;
+	memset(&view->latency, 0, sizeof(view->latency));
 	view->id = server->views_curr_id;
 	++server->views_curr_id;
 	view->scene_tree = wlr_scene_tree_create(
@@ -10,6 +10,8 @@
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_compositor.h>
 
+struct cg_launch_stats;
+struct cg_output;
 struct cg_server;
 struct wlr_box;
 
@@ -20,6 +22,32 @@ enum cg_view_type {
 #endif
 };
 
+/* Time from a commit of the view to the presentation of the first frame
+ * containing it */
+struct cg_view_latency {
+	uint64_t committed_ns; // Oldest commit which was not drawn yet, 0 if none
+	uint64_t drawn_ns; // Oldest commit drawn, but not yet presented, 0 if none
+	uint64_t last_ns;
+	uint64_t max_ns;
+	uint64_t sum_ns;
+	uint32_t count;
+};
+
+/* Launch of the first view of a command run by "exec", from the map of the
+ * view until its next commit */
+struct cg_view_launch {
+	struct cg_launch_stats *stats; // NULL if no launch is being measured
+	uint64_t spawn_ns;
+	uint64_t map_ns;
+	uint32_t map_seq; // Sequence number of the surface state at the map
+};
+
+/* The parts of the state of a surface which affect pointer hit tests */
+struct cg_surface_shape {
+	int width, height;
+	uint32_t subsurfaces; // Hash of the direct subsurfaces and positions
+};
+
 struct cg_view {
 	struct cg_workspace *workspace;
 	struct cg_server *server;
@@ -31,6 +59,11 @@ struct cg_view {
 	struct wl_listener destroy;
 	struct wl_listener unmap;
 	struct wl_listener map;
+	struct wl_listener commit;
+
+	struct cg_view_latency latency;
+	struct cg_view_launch launch;
+	struct cg_surface_shape shape;
 
 	/* The view has a position in output coordinates. */
 	int ox, oy;
@@ -73,5 +106,12 @@ view_init(struct cg_view *view, enum cg_view_type type,
           const struct cg_view_impl *impl, struct cg_server *server);
 struct cg_view *
 view_get_prev_view(struct cg_view *view);
+bool
+view_surface_shape_update(struct cg_surface_shape *shape,
+                          struct wlr_surface *surface);
+void
+view_latency_drawn(struct cg_output *output, uint64_t commit_ns);
+void
+view_latency_presented(struct cg_output *output, uint64_t when_ns);
 
 #endif
@@ -4,6 +4,7 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include <stdlib.h>
+#include <string.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_scene.h>
@@ -27,6 +28,7 @@ workspace_tile_update_view(struct cg_tile *tile, struct cg_view *view) {
 		view_maximize(view, tile);
 		wlr_scene_node_set_enabled(&view->scene_tree->node, true);
 	}
+	++tile->workspace->server->scene_generation;
 }
 
 int
@@ -45,6 +47,7 @@ full_screen_workspace_tiles(struct cg_workspace *workspace,
 	    output_get_layout_box(workspace->output).width;
 	workspace->focused_tile->tile.height =
 	    output_get_layout_box(workspace->output).height;
+	++workspace->server->layout_generation;
 	workspace_tile_update_view(workspace->focused_tile, NULL);
 	workspace->focused_tile->id = *tiles_curr_id;
 	++(*tiles_curr_id);
@@ -78,18 +81,13 @@ full_screen_workspace(struct cg_output *output) {
 void
 workspace_focus_tile(struct cg_workspace *ws, struct cg_tile *tile) {
 	ws->focused_tile = tile;
-	struct wlr_box *box = malloc(sizeof(struct wlr_box));
-	if(!box) {
-		wlr_log(WLR_ERROR, "Failed to allocate box required to focus tile");
-		return;
-	}
-	box->x = tile->tile.x + tile->tile.width / 2;
-	box->y = tile->tile.y + tile->tile.height / 2;
-	message_printf_pos(ws->output, box, CG_MESSAGE_CENTER, "Current tile");
+	message_indicator(ws->output, CG_INDICATOR_TILE, &tile->tile);
 }
 
 void
 workspace_free_tiles(struct cg_workspace *workspace) {
+	++workspace->server->scene_generation;
+	++workspace->server->layout_generation;
 	workspace->focused_tile->prev->next = NULL;
 	while(workspace->focused_tile != NULL) {
 		if(workspace->server->seat != NULL &&
@@ -103,10 +101,149 @@ workspace_free_tiles(struct cg_workspace *workspace) {
 	}
 }
 
+static void
+tile_index_clear(struct cg_tile_index *index) {
+	free(index->offsets);
+	free(index->tiles);
+	memset(index, 0, sizeof(*index));
+}
+
+static bool
+tile_contains(const struct cg_tile *tile, double ox, double oy) {
+	return tile->tile.x <= ox && tile->tile.y <= oy &&
+	       tile->tile.x + tile->tile.width >= ox &&
+	       tile->tile.y + tile->tile.height >= oy;
+}
+
+static uint32_t
+tile_index_cell(const struct cg_tile_index *index, int32_t pos,
+                int32_t cell_size) {
+	if(pos < 0) {
+		return 0;
+	}
+	uint32_t cell = pos / cell_size;
+	return cell < index->dim ? cell : index->dim - 1;
+}
+
+/* Adds tile to all cells it intersects. If tiles is NULL, the cells are only
+ * counted in offsets, otherwise tiles is filled at the positions in fill. */
+static void
+tile_index_insert(struct cg_tile_index *index, struct cg_tile *tile,
+                  uint32_t *fill) {
+	uint32_t x0 = tile_index_cell(index, tile->tile.x, index->cell_width);
+	uint32_t x1 = tile_index_cell(index, tile->tile.x + tile->tile.width,
+	                              index->cell_width);
+	uint32_t y0 = tile_index_cell(index, tile->tile.y, index->cell_height);
+	uint32_t y1 = tile_index_cell(index, tile->tile.y + tile->tile.height,
+	                              index->cell_height);
+	for(uint32_t y = y0; y <= y1; ++y) {
+		for(uint32_t x = x0; x <= x1; ++x) {
+			uint32_t cell = y * index->dim + x;
+			if(fill == NULL) {
+				++index->offsets[cell + 1];
+			} else {
+				index->tiles[fill[cell]++] = tile;
+			}
+		}
+	}
+}
+
+static void
+tile_index_build(struct cg_workspace *ws) {
+	struct cg_tile_index *index = &ws->tile_index;
+	tile_index_clear(index);
+	index->generation = ws->server->layout_generation;
+
+	uint32_t ntiles = 0;
+	struct cg_tile *tile = ws->focused_tile;
+	do {
+		++ntiles;
+		tile = tile->next;
+	} while(tile != ws->focused_tile);
+
+	struct wlr_box box = output_get_layout_box(ws->output);
+	if(box.width <= 0 || box.height <= 0) {
+		return;
+	}
+	index->dim = 1;
+	while(index->dim * index->dim < ntiles &&
+	      index->dim < CG_TILE_INDEX_MAX_DIM) {
+		++index->dim;
+	}
+	index->cell_width = (box.width + index->dim - 1) / index->dim;
+	index->cell_height = (box.height + index->dim - 1) / index->dim;
+
+	uint32_t ncells = index->dim * index->dim;
+	index->offsets = calloc(ncells + 1, sizeof(uint32_t));
+	uint32_t *fill = malloc(ncells * sizeof(uint32_t));
+	if(index->offsets == NULL || fill == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate tile index");
+		free(fill);
+		tile_index_clear(index);
+		return;
+	}
+	do {
+		tile_index_insert(index, tile, NULL);
+		tile = tile->next;
+	} while(tile != ws->focused_tile);
+	for(uint32_t i = 0; i < ncells; ++i) {
+		index->offsets[i + 1] += index->offsets[i];
+	}
+	memcpy(fill, index->offsets, ncells * sizeof(uint32_t));
+
+	index->tiles = malloc(index->offsets[ncells] * sizeof(struct cg_tile *));
+	if(index->tiles == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate tile index");
+		free(fill);
+		tile_index_clear(index);
+		return;
+	}
+	do {
+		tile_index_insert(index, tile, fill);
+		tile = tile->next;
+	} while(tile != ws->focused_tile);
+	free(fill);
+	index->valid = true;
+}
+
+/* Returns the tile containing the point (ox, oy) in output coordinates, or
+ * NULL if there is none */
+struct cg_tile *
+workspace_tile_at(struct cg_workspace *ws, double ox, double oy) {
+	struct cg_tile_index *index = &ws->tile_index;
+	if(!index->valid || index->generation != ws->server->layout_generation) {
+		tile_index_build(ws);
+	}
+	if(index->valid) {
+		uint32_t cell =
+		    tile_index_cell(index, oy, index->cell_height) * index->dim +
+		    tile_index_cell(index, ox, index->cell_width);
+		for(uint32_t i = index->offsets[cell]; i < index->offsets[cell + 1];
+		    ++i) {
+			if(tile_contains(index->tiles[i], ox, oy)) {
+				return index->tiles[i];
+			}
+		}
+	}
+
+	/* If the geometry of a tile changed without a new layout generation the
+	 * index is stale, so check every tile and rebuild it on a hit */
+	struct cg_tile *tile = ws->focused_tile;
+	do {
+		if(tile_contains(tile, ox, oy)) {
+			index->valid = false;
+			return tile;
+		}
+		tile = tile->next;
+	} while(tile != ws->focused_tile);
+	return NULL;
+}
+
 void
 workspace_free(struct cg_workspace *workspace) {
 	wlr_scene_node_destroy(&workspace->scene->node);
 	workspace_free_tiles(workspace);
+	tile_index_clear(&workspace->tile_index);
 	free(workspace);
 }
 
@@ -129,6 +266,8 @@ workspace_focus(struct cg_output *outp, int ws) {
 	// Keep layer shell top and overlay above workspaces
 	wlr_scene_node_raise_to_top(&outp->layer_shell_top->node);
 	wlr_scene_node_raise_to_top(&outp->layer_shell_overlay->node);
+	overlay_raise(outp);
 
 	outp->curr_workspace = ws;
+	++outp->server->scene_generation;
 }
@@ -4,6 +4,7 @@
 #ifndef CG_WORKSPACE_H
 #define CG_WORKSPACE_H
 
+#include <stdbool.h>
 #include <wlr/util/box.h>
 
 struct cg_output;
@@ -18,6 +19,22 @@ struct cg_tile {
 	uint32_t id;
 };
 
+// Upper bound for the number of cells per row and column of a tile index
+#define CG_TILE_INDEX_MAX_DIM 32
+
+/* Uniform grid over the tiles of a workspace, used to find the tile at a
+ * point without walking all tiles. It is rebuilt lazily whenever
+ * cg_server::layout_generation changes. */
+struct cg_tile_index {
+	uint32_t generation;
+	bool valid;
+	uint32_t dim; // Number of cells per row and column
+	int32_t cell_width;
+	int32_t cell_height;
+	uint32_t *offsets;      // dim * dim + 1 offsets into tiles, one per cell
+	struct cg_tile **tiles; // Tiles intersecting each cell
+};
+
 struct cg_workspace {
 	struct cg_server *server;
 	struct wl_list views;
@@ -26,6 +43,7 @@ struct cg_workspace {
 	struct wlr_scene_tree *scene;
 
 	struct cg_tile *focused_tile;
+	struct cg_tile_index tile_index;
 	uint32_t num;
 };
 
@@ -42,6 +60,8 @@ void
 workspace_focus_tile(struct cg_workspace *ws, struct cg_tile *tile);
 void
 workspace_focus(struct cg_output *outp, int ws);
+struct cg_tile *
+workspace_tile_at(struct cg_workspace *ws, double ox, double oy);
 void
 workspace_tile_update_view(struct cg_tile *tile, struct cg_view *view);
 
@@ -283,6 +283,7 @@ handle_xdg_shell_popup_destroy(struct wl_listener *listener,
 	wl_list_remove(&popup->commit.link);
 	wl_list_remove(&popup->reposition.link);
 	wlr_scene_node_destroy(&popup->scene_tree->node);
+	++popup->view->server->scene_generation;
 	free(popup);
 }
 
@@ -290,6 +291,11 @@ static void
 handle_xdg_shell_popup_commit(struct wl_listener *listener,
                               __attribute__((unused)) void *data) {
 	struct cg_xdg_shell_popup *popup = wl_container_of(listener, popup, commit);
+	if(view_surface_shape_update(&popup->shape,
+	                             popup->wlr_popup->base->surface) ||
+	   popup->wlr_popup->base->initial_commit) {
+		++popup->view->server->scene_generation;
+	}
 	if(popup->wlr_popup->base->initial_commit) {
 		popup_unconstrain(popup);
 	}
@@ -300,6 +306,7 @@ handle_xdg_shell_popup_reposition(struct wl_listener *listener,
                                   __attribute__((unused)) void *data) {
 	struct cg_xdg_shell_popup *popup =
 	    wl_container_of(listener, popup, reposition);
+	++popup->view->server->scene_generation;
 	popup_unconstrain(popup);
 }
 
@@ -23,6 +23,7 @@ struct cg_xdg_shell_popup {
 	struct wlr_xdg_popup *wlr_popup;
 	struct wlr_scene_tree *scene_tree;
 	struct wlr_scene_tree *xdg_surface_tree;
+	struct cg_surface_shape shape;
 
 	struct wl_listener commit;
 	struct wl_listener new_popup;
@@ -8,6 +8,7 @@
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_scene.h>
+#include <wlr/types/wlr_xcursor_manager.h>
 #include <wlr/util/box.h>
 #include <wlr/util/log.h>
 #if CG_HAS_XWAYLAND
@@ -15,6 +16,7 @@
 #endif
 
 #include "output.h"
+#include "seat.h"
 #include "server.h"
 #include "view.h"
 #include "workspace.h"
@@ -232,3 +234,18 @@ handle_xwayland_surface_new(struct wl_listener *listener, void *data) {
 	wl_signal_add(&xwayland_surface->events.request_fullscreen,
 	              &xwayland_view->request_fullscreen);
 }
+
+/* Sets the cursor shown by XWayland over surfaces which do not set one, once
+ * the cursor theme is loaded */
+void
+xwayland_set_default_cursor(struct cg_server *server) {
+	struct wlr_xcursor *xcursor = wlr_xcursor_manager_get_xcursor(
+	    server->seat->xcursor_manager, DEFAULT_XCURSOR, 1);
+
+	if(xcursor) {
+		struct wlr_xcursor_image *image = xcursor->images[0];
+		wlr_xwayland_set_cursor(server->xwayland,
+		                        wlr_xcursor_image_get_buffer(image),
+		                        image->hotspot_x, image->hotspot_y);
+	}
+}
@@ -25,5 +25,7 @@ bool
 xwayland_view_should_manage(const struct cg_view *view);
 void
 handle_xwayland_surface_new(struct wl_listener *listener, void *data);
+void
+xwayland_set_default_cursor(struct cg_server *server);
 
 #endif